@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////
+// acceptor.cpp -- Batched accept(2) of connections
+// Date: Mon Oct 19 21:06:14 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/epoll.h>
+
+#include "acceptor.hpp"
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE	(1u << 28)		// Linux 4.5
+#endif
+
+Acceptor::Acceptor(int lsock,fun_t *conn_func,const SockOptions& opts,unsigned budget)
+  : Service(accept_func,lsock), conn_func(conn_func), opts(opts), budget(budget ? budget : 1) {
+	int domain = AF_INET;
+	socklen_t len = sizeof domain;
+
+	spare = ::open("/dev/null",O_RDONLY|O_CLOEXEC);
+	getsockopt(lsock,SOL_SOCKET,SO_DOMAIN,&domain,&len);
+	unixf = domain == AF_UNIX;
+	set_tcp(!unixf);
+}
+
+Acceptor::~Acceptor() {
+	if ( spare >= 0 )
+		::close(spare);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Register the listening socket with the scheduler. EPOLLEXCLUSIVE
+// can only be given when the socket is added (not modified), so the
+// Acceptor never changes its events.
+//////////////////////////////////////////////////////////////////////
+
+bool
+Acceptor::start(Scheduler& scheduler,bool exclusive) {
+
+	sched = &scheduler;
+	return scheduler.add(socket(),EPOLLIN | (exclusive ? EPOLLEXCLUSIVE : 0),this);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Out of file descriptors: accept and close one pending connection
+// using the spare fd, so that a level triggered listening socket does
+// not wake us continuously while nothing can be accepted.
+//////////////////////////////////////////////////////////////////////
+
+int
+Acceptor::shed() {
+	int fd;
+
+	if ( spare < 0 )
+		return -1;
+	::close(spare);
+	fd = ::accept4(socket(),nullptr,nullptr,SOCK_CLOEXEC);
+	if ( fd >= 0 ) {
+		::close(fd);
+		++dropped;
+	}
+	spare = ::open("/dev/null",O_RDONLY|O_CLOEXEC);
+	return fd;
+}
+
+CoroutineBase *
+Acceptor::accept_func(CoroutineBase *co) {
+	Acceptor& acc = *(Acceptor *)co;
+	const int lsock = acc.socket();
+	unsigned n = 0;				// Accepted this wakeup
+	int fd;
+
+	for (;;) {
+		if ( n >= acc.budget ) {
+			++acc.yields;
+			n = 0;
+			acc.yield();		// Let ready services run first
+			continue;
+		}
+
+		fd = ::accept4(lsock,nullptr,nullptr,SOCK_NONBLOCK|SOCK_CLOEXEC);
+		if ( fd < 0 ) {
+			switch ( errno ) {
+			case EINTR:
+			case ECONNABORTED:
+			case EPROTO:
+			case EPERM:
+				continue;	// This connection only
+			case EMFILE:
+			case ENFILE:
+				if ( acc.shed() >= 0 ) {
+					++n;	// Counts against the budget
+					continue;
+				}
+				break;
+			default:
+				break;		// EAGAIN, ENOBUFS, ENOMEM ..
+			}
+			n = 0;
+			acc.yield();		// Yield to epoll
+			continue;
+		}
+
+		if ( !acc.unixf )
+			Sockets::accepted(fd,acc.opts);	// Tuning only: failure is not fatal
+
+		// Started at once: the first read is tried before epoll
+		Service *svc = new Service(acc.conn_func,fd);
+
+		svc->set_tcp(!acc.unixf);
+
+		acc.sched->start(*svc,EPOLLIN|EPOLLHUP|EPOLLRDHUP|EPOLLERR);
+		++acc.accepted;
+		++n;
+	}
+
+	return nullptr;
+}
+
+// End acceptor.cpp
@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////
+// acceptor.hpp -- Batched accept(2) of connections
+// Date: Mon Oct 19 21:06:14 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// An Acceptor is the Service of a listening socket. Each wakeup it
+// accepts connections until accept4(2) would block, or until budget
+// connections were taken: it then yields so that the Scheduler serves
+// the other ready services first (the listening socket is level
+// triggered, so the rest are accepted on the next wakeup). A storm of
+// connections therefore cannot starve existing clients. Accepted
+// connections are started in the same wakeup (Scheduler::start()),
+// so their first read is tried before registering with epoll(2).
+//
+// When several Schedulers share one listening socket, each adds it
+// with exclusive set (EPOLLEXCLUSIVE), so that a new connection wakes
+// one of them rather than all (thundering herd).
+///////////////////////////////////////////////////////////////////////
+
+#ifndef ACCEPTOR_HPP
+#define ACCEPTOR_HPP
+
+#include "scheduler.hpp"
+
+class Acceptor : public Service {
+	fun_t		*conn_func;		// Coroutine of accepted connections
+	SockOptions	opts;			// For Sockets::accepted()
+	unsigned	budget;			// Connections accepted per wakeup
+	Scheduler	*sched = nullptr;	// Scheduler we were started on
+	int		spare = -1;		// Reserved fd, for EMFILE/ENFILE
+	bool		unixf = false;		// Listening on an AF_UNIX socket
+
+	static CoroutineBase *accept_func(CoroutineBase *co);
+	int shed();
+
+public:	size_t		accepted = 0;		// Connections accepted
+	size_t		yields = 0;		// Wakeups ended by the budget
+	size_t		dropped = 0;		// Connections closed: out of fds
+
+	static const unsigned default_budget = 64;
+
+	Acceptor(int lsock,fun_t *conn_func,const SockOptions& opts,unsigned budget=default_budget);
+	~Acceptor();
+
+	bool start(Scheduler& scheduler,bool exclusive=false);
+	void set_budget(unsigned budget) noexcept { this->budget = budget ? budget : 1; }
+};
+
+#endif // ACCEPTOR_HPP
+
+// End acceptor.hpp
@@ -0,0 +1,187 @@
+//////////////////////////////////////////////////////////////////////
+// arena.cpp -- Per-request monotonic memory arena
+// Date: Mon Oct 19 10:05:17 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arena.hpp"
+
+Arena::~Arena() {
+	Block *next;
+
+	for ( Block *blk = head; blk; blk = next ) {
+		next = blk->next;
+		::free(blk);
+	}
+	head = cur = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Internal: Allocate a block with at least bytes of usable space
+//////////////////////////////////////////////////////////////////////
+
+Arena::Block *
+Arena::new_block(size_t bytes) {
+	size_t size = bytes > block_size ? bytes : block_size;
+	Block *blk = (Block *)::malloc(offsetof(Block,data) + size);
+
+	if ( !blk )
+		throw std::bad_alloc();
+	blk->next = nullptr;
+	blk->size = size;
+	return blk;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Allocate bytes with alignment align (a power of 2). Blocks retained
+// from before the last reset() are reused before a new one is made.
+//////////////////////////////////////////////////////////////////////
+
+void *
+Arena::alloc(size_t bytes,size_t align) {
+	size_t off;
+
+	assert(align && !(align & (align - 1)));
+
+	if ( !cur ) {
+		if ( !head )
+			head = new_block(bytes);
+		cur = head;
+		used = 0;
+	}
+
+	for (;;) {
+		off = (used + align - 1) & ~(align - 1);
+		if ( off + bytes <= cur->size ) {
+			used = off + bytes;
+			return cur->data + off;
+		}
+		if ( cur->next && cur->next->size < bytes ) {
+			// Retained block is too small for this request: insert a new one
+			Block *blk = new_block(bytes);
+
+			blk->next = cur->next;
+			cur->next = blk;
+		} else if ( !cur->next )
+			cur->next = new_block(bytes);
+		cur = cur->next;
+		used = 0;
+	}
+}
+
+char *
+Arena::strdup(const char *str,size_t len) {
+	char *s = (char *)alloc(len + 1,1);
+
+	memcpy(s,str,len);
+	s[len] = 0;
+	return s;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Release all allocations, retaining blocks for reuse
+//////////////////////////////////////////////////////////////////////
+
+void
+Arena::reset() noexcept {
+	cur = head;
+	used = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return total bytes held by the arena
+//////////////////////////////////////////////////////////////////////
+
+size_t
+Arena::capacity() const noexcept {
+	size_t total = 0;
+
+	for ( Block *blk = head; blk; blk = blk->next )
+		total += blk->size;
+	return total;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Slab allocator
+//////////////////////////////////////////////////////////////////////
+
+Slab::~Slab() {
+	trim();
+}
+
+void *
+Slab::alloc(size_t bytes) {
+	int cls = 0;
+	Hdr *h;
+
+	++allocs;
+	while ( cls < n_classes && (size_t(1) << (cls + min_shift)) < bytes )
+		++cls;
+
+	if ( cls >= n_classes ) {
+		h = (Hdr *)::malloc(sizeof(Hdr) + bytes);
+		if ( !h )
+			return nullptr;
+		h->cls = -1;
+		return h + 1;
+	}
+
+	if ( (h = freelist[cls]) != nullptr ) {
+		freelist[cls] = h->next;
+		cached -= size_t(1) << (cls + min_shift);
+		++reused;
+	} else	{
+		h = (Hdr *)::malloc(sizeof(Hdr) + (size_t(1) << (cls + min_shift)));
+		if ( !h )
+			return nullptr;
+	}
+	h->cls = cls;
+	return h + 1;
+}
+
+void
+Slab::free(void *p) noexcept {
+	Hdr *h;
+	size_t size;
+
+	if ( !p )
+		return;
+	h = (Hdr *)p - 1;
+	if ( h->cls < 0 ) {
+		::free(h);
+		return;
+	}
+	size = size_t(1) << (h->cls + min_shift);
+	if ( cached + size > max_cached ) {
+		::free(h);
+		return;
+	}
+	h->next = freelist[h->cls];
+	freelist[h->cls] = h;
+	cached += size;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return all cached blocks to malloc
+//////////////////////////////////////////////////////////////////////
+
+void
+Slab::trim() noexcept {
+
+	for ( int x=0; x<n_classes; ++x ) {
+		while ( Hdr *h = freelist[x] ) {
+			freelist[x] = h->next;
+			::free(h);
+		}
+	}
+	cached = 0;
+}
+
+// End arena.cpp
@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////
+// arena.hpp -- Per-request monotonic memory arena
+// Date: Mon Oct 19 10:02:51 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <stddef.h>
+#include <string.h>
+#include <new>
+
+#include "utility.hpp"
+
+//////////////////////////////////////////////////////////////////////
+// Monotonic arena: allocations are released all at once by reset(),
+// which keeps the blocks for reuse. Once a connection's arena has
+// grown to fit its requests, no further malloc is done.
+//////////////////////////////////////////////////////////////////////
+
+class Arena {
+	struct Block {
+		Block	*next;			// Next block in chain
+		size_t	size;			// Usable size of this block
+		alignas(alignof(max_align_t)) char data[1];
+	};
+
+	Block		*head=nullptr;		// First block
+	Block		*cur=nullptr;		// Block being allocated from
+	size_t		used=0;			// Bytes used in cur
+	size_t		block_size;		// Minimum block size
+
+	Block *new_block(size_t bytes);
+
+public:	Arena(size_t block_size=4096) : block_size(block_size) {}
+	~Arena();
+
+	void *alloc(size_t bytes,size_t align=alignof(max_align_t));
+	char *strdup(const char *str,size_t len);
+	Slice copy(const Slice& slice)		{ return Slice(strdup(slice.data,slice.size),slice.size); }
+	void reset() noexcept;
+	size_t capacity() const noexcept;
+};
+
+//////////////////////////////////////////////////////////////////////
+// Standard allocator adapter, for containers living in an Arena
+// (deallocate is a no-op):
+//////////////////////////////////////////////////////////////////////
+
+template<typename T>
+class ArenaAllocator {
+	template<typename U> friend class ArenaAllocator;
+	Arena		*arena;
+
+public:	typedef T value_type;
+
+	ArenaAllocator(Arena& arena) noexcept : arena(&arena) {}
+	template<typename U> ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+	T *allocate(size_t n)			{ return (T *)arena->alloc(n * sizeof(T),alignof(T)); }
+	void deallocate(T *,size_t) noexcept	{ }
+
+	template<typename U> bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena == other.arena; }
+	template<typename U> bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena != other.arena; }
+};
+
+//////////////////////////////////////////////////////////////////////
+// Slab allocator: power of two size classes from 64 bytes to 256 KiB,
+// with freed blocks kept on per-class free lists (up to max_cached
+// bytes) for reuse. Larger requests go straight to malloc. Not thread
+// safe.
+//////////////////////////////////////////////////////////////////////
+
+class Slab {
+	static const int min_shift = 6;		// 64 bytes
+	static const int max_shift = 18;	// 256 KiB
+	static const int n_classes = max_shift - min_shift + 1;
+
+	union Hdr {
+		struct {
+			Hdr	*next;		// Free list link (when free)
+			int	cls;		// Size class, or -1 for malloc
+		};
+		max_align_t	align;		// Keeps user data aligned
+	};
+
+	Hdr		*freelist[n_classes];	// Free blocks by class
+	size_t		cached = 0;		// Bytes on free lists
+	size_t		max_cached;		// Limit on cached bytes
+
+public:	size_t		allocs = 0;		// Requests made
+	size_t		reused = 0;		// Requests met from free lists
+
+	Slab(size_t max_cached=4*1024*1024) : max_cached(max_cached) { memset(freelist,0,sizeof freelist); }
+	~Slab();
+
+	void *alloc(size_t bytes);
+	void free(void *p) noexcept;
+	void trim() noexcept;
+};
+
+#endif // ARENA_HPP
+
+// End arena.hpp
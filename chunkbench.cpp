@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////
+// chunkbench.cpp -- Benchmark of chunked body decoding
+// Date: Mon Oct 19 09:41:27 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+#include <string>
+#include <sstream>
+
+#include "chunked.hpp"
+#include "httpbuf.hpp"
+
+static std::string input;		// Simulated socket input
+static size_t input_pos = 0;		// Read position in input
+
+//////////////////////////////////////////////////////////////////////
+// Read callback, simulating socket reads of up to 64k:
+//////////////////////////////////////////////////////////////////////
+
+static int
+read_cb(int fd,void *buf,size_t bytes,void *arg) {
+	size_t n = input.size() - input_pos;
+
+	if ( n > bytes )
+		n = bytes;
+	if ( n > 65536 )
+		n = 65536;
+	memcpy(buf,input.data() + input_pos,n);
+	input_pos += n;
+	return int(n);
+}
+
+static double
+elapsed(const timespec& t0) {
+	timespec t1;
+
+	clock_gettime(CLOCK_MONOTONIC,&t1);
+	return double(t1.tv_sec - t0.tv_sec) + double(t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+static void
+report(const char *what,size_t bytes,double secs) {
+	printf("%-28s %10.1f MB/s  (%.3f secs)\n",what,double(bytes) / secs / 1e6,secs);
+}
+
+int
+main(int argc,char **argv) {
+	const size_t body_size = argc > 1 ? strtoul(argv[1],nullptr,10) << 20 : size_t(64) << 20;
+	const char hdr[] = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+	std::string payload(body_size,'x');
+	size_t bpos, total;
+	timespec t0;
+	char size[32];
+
+	//////////////////////////////////////////////////////////////
+	// Build a chunked request with chunk sizes from 1 to 16k:
+	//////////////////////////////////////////////////////////////
+
+	input.assign(hdr);
+	srand(42);
+	for ( size_t x=0; x < body_size; ) {
+		size_t n = size_t(rand()) % 16384 + 1;
+
+		if ( n > body_size - x )
+			n = body_size - x;
+		snprintf(size,sizeof size,"%zx\r\n",n);
+		input.append(size);
+		input.append(payload,x,n);
+		input.append("\r\n");
+		x += n;
+	}
+	input.append("0\r\n\r\n");
+	bpos = sizeof hdr - 1;
+
+	printf("Body %zu MiB, %zu bytes chunked\n",body_size >> 20,input.size() - bpos);
+
+	//////////////////////////////////////////////////////////////
+	// ChunkDecoder over 64k slices (zero-copy runs):
+	//////////////////////////////////////////////////////////////
+	{
+		ChunkDecoder decoder;
+		const char *run;
+		size_t runlen, x = bpos;
+
+		total = 0;
+		clock_gettime(CLOCK_MONOTONIC,&t0);
+		while ( x < input.size() && decoder.status() == ChunkDecoder::More ) {
+			size_t n = input.size() - x < 65536 ? input.size() - x : 65536;
+			size_t used = 0;
+
+			while ( used < n && decoder.status() == ChunkDecoder::More ) {
+				used += decoder.decode(input.data() + x + used,n - used,&run,&runlen);
+				total += runlen;
+			}
+			x += used;
+		}
+		report("ChunkDecoder::decode",total,elapsed(t0));
+		assert(decoder.status() == ChunkDecoder::Done && total == body_size);
+	}
+
+	//////////////////////////////////////////////////////////////
+	// HttpBuf::read_body_chunk() streaming into a 16k buffer:
+	//////////////////////////////////////////////////////////////
+	{
+		HttpBuf hbuf;
+		std::string reqtype, path, httpvers;
+		headermap_t headers;
+		char buf[16384];
+		int rc;
+
+		input_pos = 0;
+		total = 0;
+		clock_gettime(CLOCK_MONOTONIC,&t0);
+		rc = hbuf.read_header(0,read_cb,nullptr);
+		assert(rc == 1);
+		hbuf.parse_headers(reqtype,path,httpvers,headers);
+		hbuf.begin_body(0,true);
+		while ( (rc = hbuf.read_body_chunk(0,read_cb,nullptr,buf,sizeof buf)) > 0 )
+			total += size_t(rc);
+		report("HttpBuf::read_body_chunk",total,elapsed(t0));
+		assert(rc == 0 && total == body_size);
+	}
+
+	//////////////////////////////////////////////////////////////
+	// HttpBuf::read_chunked() into a std::stringstream:
+	//////////////////////////////////////////////////////////////
+	{
+		HttpBuf hbuf;
+		std::string reqtype, path, httpvers;
+		headermap_t headers;
+		std::stringstream unchunked;
+		int rc;
+
+		input_pos = 0;
+		clock_gettime(CLOCK_MONOTONIC,&t0);
+		rc = hbuf.read_header(0,read_cb,nullptr);
+		assert(rc == 1);
+		hbuf.parse_headers(reqtype,path,httpvers,headers);
+		rc = hbuf.read_chunked(0,read_cb,nullptr,unchunked);
+		report("HttpBuf::read_chunked",size_t(rc),elapsed(t0));
+		assert(size_t(rc) == body_size);
+	}
+
+	return 0;
+}
+
+// End chunkbench.cpp
@@ -0,0 +1,261 @@
+//////////////////////////////////////////////////////////////////////
+// chunked.cpp -- Chunked transfer-encoding decoder
+// Date: Mon Oct 19 09:14:02 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+#include "chunked.hpp"
+
+//////////////////////////////////////////////////////////////////////
+// Return the value of hex digit ch, else -1
+//////////////////////////////////////////////////////////////////////
+
+static inline int
+hexval(unsigned char ch) noexcept {
+
+	if ( unsigned(ch - '0') < 10u )
+		return ch - '0';
+	ch |= 0x20;				// Lowercase
+	if ( unsigned(ch - 'a') < 6u )
+		return ch - 'a' + 10;
+	return -1;
+}
+
+void
+ChunkDecoder::reset() noexcept {
+	state = D_Size;
+	fault = F_None;
+	chunk_left = 0;
+	body_total = 0;
+	in_total = 0;
+	trailer_pos = 0;
+	line_len = 0;
+	digits = 0;
+	trailerf = false;
+}
+
+void
+ChunkDecoder::limits(uint64_t max_chunk,uint64_t max_body,size_t max_line) noexcept {
+	this->max_chunk = max_chunk;
+	this->max_body = max_body;
+	this->max_line = max_line;
+}
+
+ChunkDecoder::Status
+ChunkDecoder::status() const noexcept {
+
+	switch ( state ) {
+	case D_Done:
+		return Done;
+	case D_Error:
+		return Error;
+	default:
+		return More;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Internal: The chunk size line has ended at input offset offset
+//////////////////////////////////////////////////////////////////////
+
+void
+ChunkDecoder::end_size(uint64_t offset) noexcept {
+
+	if ( !digits ) {
+		fail(F_Format);			// No chunk size given
+		return;
+	}
+	digits = 0;
+	line_len = 0;
+
+	if ( chunk_left == 0 ) {
+		trailer_pos = offset;		// Last chunk: trailer-part follows
+		state = D_Trailer;
+	} else if ( max_body && body_total + chunk_left > max_body ) {
+		fail(F_BodySize);
+	} else	state = D_Data;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Decode input data[0..bytes-1], stopping after the first run of
+// chunk payload (if any):
+//
+// RETURNS:
+//	Number of input bytes consumed. When payload was found,
+//	*prun points to it within data, with length *prunlen.
+//	Otherwise *prun is nullptr and *prunlen is zero.
+// NOTES:
+//	1. Call repeatedly until all input is consumed, or
+//	   status() is no longer More.
+//	2. Input beyond the end of the chunked body is not consumed.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+ChunkDecoder::decode(const char *data,size_t bytes,const char **prun,size_t *prunlen) noexcept {
+	const char *p = data, *e = data + bytes, *q;
+	size_t n;
+	int v;
+
+	*prun = nullptr;
+	*prunlen = 0;
+
+	while ( p < e ) {
+		switch ( state ) {
+		case D_Data:
+			n = size_t(e - p);
+			if ( n > chunk_left )
+				n = size_t(chunk_left);
+			*prun = p;
+			*prunlen = n;
+			p += n;
+			chunk_left -= n;
+			body_total += n;
+			if ( !chunk_left )
+				state = D_DataCR;
+			in_total += uint64_t(p - data);
+			return size_t(p - data);	// Hand out this run
+
+		case D_Size:
+			if ( ++line_len > max_line ) {
+				fail(F_LineSize);
+				break;
+			}
+			if ( (v = hexval(*p)) >= 0 ) {
+				if ( chunk_left > max_chunk / 16u || chunk_left * 16u + unsigned(v) > max_chunk ) {
+					fail(F_ChunkSize);
+					break;
+				}
+				chunk_left = chunk_left * 16u + unsigned(v);
+				++digits;
+				++p;
+			} else	{
+				switch ( *p++ ) {
+				case '\r':
+					state = D_SizeLF;
+					break;
+				case '\n':
+					end_size(in_total + uint64_t(p - data));
+					break;
+				case ';':
+				case ' ':
+				case '\t':
+					state = D_Ext;
+					break;
+				default:
+					fail(F_Format);
+				}
+			}
+			break;
+
+		case D_Ext:
+			q = (const char *)memchr(p,'\n',size_t(e - p));
+			n = size_t((q ? q : e) - p);
+			if ( (line_len += n) > max_line ) {
+				fail(F_LineSize);
+				break;
+			}
+			p += n;
+			if ( q )
+				end_size(in_total + uint64_t(++p - data));
+			break;
+
+		case D_SizeLF:
+			if ( *p++ == '\n' )
+				end_size(in_total + uint64_t(p - data));
+			else	fail(F_Format);
+			break;
+
+		case D_DataCR:
+			if ( *p == '\r' )
+				state = D_DataLF;
+			else if ( *p == '\n' )
+				state = D_Size;		// Tolerate bare LF
+			else	fail(F_Format);
+			++p;
+			break;
+
+		case D_DataLF:
+			if ( *p++ == '\n' )
+				state = D_Size;
+			else	fail(F_Format);
+			break;
+
+		case D_Trailer:
+			if ( *p == '\r' )
+				state = D_TrailerLF;
+			else if ( *p == '\n' )
+				state = D_Done;
+			else	{
+				trailerf = true;
+				state = D_TrailerLine;
+				continue;		// Scan line from this char
+			}
+			++p;
+			break;
+
+		case D_TrailerLF:
+			if ( *p++ == '\n' )
+				state = D_Done;
+			else	fail(F_Format);
+			break;
+
+		case D_TrailerLine:
+			q = (const char *)memchr(p,'\n',size_t(e - p));
+			n = size_t((q ? q : e) - p);
+			if ( (line_len += n) > max_line ) {
+				fail(F_LineSize);
+				break;
+			}
+			p += n;
+			if ( q ) {
+				++p;
+				line_len = 0;
+				state = D_Trailer;
+			}
+			break;
+
+		case D_Done:
+		case D_Error:
+			in_total += uint64_t(p - data);
+			return size_t(p - data);
+		}
+	}
+
+	in_total += uint64_t(p - data);
+	return size_t(p - data);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Remove chunked framing in place. Payload bytes are compacted to the
+// front of data, and the payload length returned through *pout.
+//
+// RETURNS:
+//	Number of input bytes consumed. This is less than bytes only
+//	when the end of the body was reached, or an error occurred.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+ChunkDecoder::unchunk(char *data,size_t bytes,size_t *pout) noexcept {
+	const char *run;
+	size_t x = 0, out = 0, runlen;
+
+	while ( x < bytes && state != D_Done && state != D_Error ) {
+		x += decode(data + x,bytes - x,&run,&runlen);
+		if ( runlen > 0 ) {
+			if ( run != data + out )
+				memmove(data + out,run,runlen);
+			out += runlen;
+		}
+	}
+	*pout = out;
+	return x;
+}
+
+// End chunked.cpp
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////
+// chunked.hpp -- Chunked transfer-encoding decoder
+// Date: Mon Oct 19 09:12:40 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef CHUNKED_HPP
+#define CHUNKED_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+//////////////////////////////////////////////////////////////////////
+// Resumable decoder for a chunked body. Input may be supplied in
+// pieces of any size, and chunk payload is handed out as runs
+// pointing into the caller's input (no copying).
+//////////////////////////////////////////////////////////////////////
+
+class ChunkDecoder {
+public:	enum Status {
+		More,			// More input is required
+		Done,			// Last chunk and trailer-part were read
+		Error			// Malformed input, or limit exceeded
+	};
+
+	enum Fault {
+		F_None,
+		F_Format,		// Bad chunk size or CRLF framing
+		F_ChunkSize,		// Chunk larger than max_chunk
+		F_BodySize,		// Body larger than max_body
+		F_LineSize		// Size, extension or trailer line too long
+	};
+
+private:
+	enum {
+		D_Size, D_Ext, D_SizeLF,	// Chunk size line
+		D_Data, D_DataCR, D_DataLF,	// Chunk data and its CRLF
+		D_Trailer, D_TrailerLF,		// Start of a trailer line
+		D_TrailerLine,			// Within a trailer line
+		D_Done, D_Error
+	}		state = D_Size;
+
+	Fault		fault = F_None;
+	uint64_t	chunk_left = 0;		// Bytes of chunk data remaining
+	uint64_t	body_total = 0;		// Payload bytes decoded
+	uint64_t	in_total = 0;		// Input bytes consumed
+	uint64_t	trailer_pos = 0;	// Input offset of the trailer-part
+	size_t		line_len = 0;		// Length of current size/ext/trailer line
+	unsigned	digits = 0;		// Hex digits in chunk size
+	bool		trailerf = false;	// True when trailer fields were seen
+
+	uint64_t	max_chunk;		// Largest chunk accepted
+	uint64_t	max_body;		// Largest body accepted (0 = no limit)
+	size_t		max_line;		// Longest size/ext/trailer line accepted
+
+	inline void end_size(uint64_t offset) noexcept;
+	inline void fail(Fault f) noexcept	{ state = D_Error; fault = f; }
+
+public:	ChunkDecoder(uint64_t max_chunk=uint64_t(1) << 40,uint64_t max_body=0,size_t max_line=4096) noexcept
+		: max_chunk(max_chunk), max_body(max_body), max_line(max_line) {}
+
+	void reset() noexcept;
+	void limits(uint64_t max_chunk,uint64_t max_body,size_t max_line=4096) noexcept;
+
+	size_t decode(const char *data,size_t bytes,const char **prun,size_t *prunlen) noexcept;
+	size_t unchunk(char *data,size_t bytes,size_t *pout) noexcept;
+
+	Status status() const noexcept;
+	Fault error() const noexcept		{ return fault; }
+	bool have_trailer() const noexcept	{ return trailerf; }
+	uint64_t trailer_offset() const noexcept { return trailer_pos; }
+	uint64_t body_size() const noexcept	{ return body_total; }
+	uint64_t consumed() const noexcept	{ return in_total; }
+};
+
+#endif // CHUNKED_HPP
+
+// End chunked.hpp
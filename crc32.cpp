@@ -0,0 +1,207 @@
+//////////////////////////////////////////////////////////////////////
+// crc32.cpp -- CRC-32 (gzip polynomial) checksums
+// Date: Mon Oct 19 20:12:48 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include "zlib.h"
+#include "crc32.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRC32_CLMUL 1
+#include <immintrin.h>
+#endif
+
+typedef uint32_t (*crc_fn_t)(uint32_t crc,const unsigned char *buf,size_t len);
+
+//////////////////////////////////////////////////////////////////////
+// Table driven CRC from zlib (uInt lengths, so large buffers are done
+// in pieces):
+//////////////////////////////////////////////////////////////////////
+
+static uint32_t
+crc_table(uint32_t crc,const unsigned char *buf,size_t len) {
+
+	while ( len > 0 ) {
+		uInt n = len > 0x40000000 ? 0x40000000 : uInt(len);
+
+		crc = uint32_t(::crc32(crc,buf,n));
+		buf += n;
+		len -= n;
+	}
+	return crc;
+}
+
+#ifdef CRC32_CLMUL
+
+//////////////////////////////////////////////////////////////////////
+// Fold 64 bytes per iteration into four 128 bit accumulators, fold
+// those into one, then Barrett reduce to 32 bits. See Intel's "Fast
+// CRC Computation for Generic Polynomials Using PCLMULQDQ". The
+// constants are powers of x mod P(x), bit reflected, for the gzip
+// polynomial 0xEDB88320.
+//
+// buf must hold at least 64 bytes, and len be a multiple of 16. crc
+// is the pre-inverted (internal) CRC, and so is the result.
+//////////////////////////////////////////////////////////////////////
+
+alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t
+crc_fold(uint32_t crc,const unsigned char *buf,size_t len) {
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+	x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+	x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+	x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+	x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+	x1 = _mm_xor_si128(x1,_mm_cvtsi32_si128(int(crc)));
+	x0 = _mm_load_si128((const __m128i *)k1k2);
+	buf += 64;
+	len -= 64;
+
+	while ( len >= 64 ) {			// Four folds in parallel
+		x5 = _mm_clmulepi64_si128(x1,x0,0x00);
+		x6 = _mm_clmulepi64_si128(x2,x0,0x00);
+		x7 = _mm_clmulepi64_si128(x3,x0,0x00);
+		x8 = _mm_clmulepi64_si128(x4,x0,0x00);
+		x1 = _mm_clmulepi64_si128(x1,x0,0x11);
+		x2 = _mm_clmulepi64_si128(x2,x0,0x11);
+		x3 = _mm_clmulepi64_si128(x3,x0,0x11);
+		x4 = _mm_clmulepi64_si128(x4,x0,0x11);
+		y5 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+		y6 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+		y7 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+		y8 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+		x1 = _mm_xor_si128(_mm_xor_si128(x1,x5),y5);
+		x2 = _mm_xor_si128(_mm_xor_si128(x2,x6),y6);
+		x3 = _mm_xor_si128(_mm_xor_si128(x3,x7),y7);
+		x4 = _mm_xor_si128(_mm_xor_si128(x4,x8),y8);
+		buf += 64;
+		len -= 64;
+	}
+
+	// Fold the four accumulators into x1:
+	x0 = _mm_load_si128((const __m128i *)k3k4);
+	x5 = _mm_clmulepi64_si128(x1,x0,0x00);
+	x1 = _mm_clmulepi64_si128(x1,x0,0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1,x2),x5);
+	x5 = _mm_clmulepi64_si128(x1,x0,0x00);
+	x1 = _mm_clmulepi64_si128(x1,x0,0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1,x3),x5);
+	x5 = _mm_clmulepi64_si128(x1,x0,0x00);
+	x1 = _mm_clmulepi64_si128(x1,x0,0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1,x4),x5);
+
+	while ( len >= 16 ) {			// Remaining 16 byte blocks
+		x2 = _mm_loadu_si128((const __m128i *)buf);
+		x5 = _mm_clmulepi64_si128(x1,x0,0x00);
+		x1 = _mm_clmulepi64_si128(x1,x0,0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1,x2),x5);
+		buf += 16;
+		len -= 16;
+	}
+
+	// Fold 128 bits to 64:
+	x2 = _mm_clmulepi64_si128(x1,x0,0x10);
+	x3 = _mm_setr_epi32(~0,0,~0,0);
+	x1 = _mm_srli_si128(x1,8);
+	x1 = _mm_xor_si128(x1,x2);
+	x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+	x2 = _mm_srli_si128(x1,4);
+	x1 = _mm_and_si128(x1,x3);
+	x1 = _mm_clmulepi64_si128(x1,x0,0x00);
+	x1 = _mm_xor_si128(x1,x2);
+
+	// Barrett reduce to 32 bits:
+	x0 = _mm_load_si128((const __m128i *)poly);
+	x2 = _mm_and_si128(x1,x3);
+	x2 = _mm_clmulepi64_si128(x2,x0,0x10);
+	x2 = _mm_and_si128(x2,x3);
+	x2 = _mm_clmulepi64_si128(x2,x0,0x00);
+	x1 = _mm_xor_si128(x1,x2);
+	return uint32_t(_mm_extract_epi32(x1,1));
+}
+
+static uint32_t
+crc_clmul(uint32_t crc,const unsigned char *buf,size_t len) {
+
+	if ( len >= 64 ) {
+		size_t n = len & ~size_t(15);
+
+		crc = ~crc_fold(~crc,buf,n);
+		buf += n;
+		len -= n;
+	}
+	return len > 0 ? crc_table(crc,buf,len) : crc;
+}
+
+#endif // CRC32_CLMUL
+
+//////////////////////////////////////////////////////////////////////
+// Select the implementation once, on first use:
+//////////////////////////////////////////////////////////////////////
+
+static crc_fn_t
+crc_select() noexcept {
+#ifdef CRC32_CLMUL
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1") )
+		return crc_clmul;
+#endif
+	return crc_table;
+}
+
+static crc_fn_t
+crc_fn() noexcept {
+	static const crc_fn_t fn = crc_select();
+
+	return fn;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Continue a CRC with len more bytes (start with crc 0), as zlib's
+// crc32() does:
+//////////////////////////////////////////////////////////////////////
+
+uint32_t
+Crc32::update(uint32_t crc,const void *buf,size_t len) noexcept {
+	return crc_fn()(crc,(const unsigned char *)buf,len);
+}
+
+//////////////////////////////////////////////////////////////////////
+// The CRC of two adjacent slices, given the CRC of each, and the
+// length of the second:
+//////////////////////////////////////////////////////////////////////
+
+uint32_t
+Crc32::combine(uint32_t crc1,uint32_t crc2,size_t len2) noexcept {
+	return uint32_t(::crc32_combine(crc1,crc2,z_off_t(len2)));
+}
+
+//////////////////////////////////////////////////////////////////////
+// The CRC of n adjacent slices, merged in order:
+//////////////////////////////////////////////////////////////////////
+
+uint32_t
+Crc32::merge(const Part *parts,size_t n) noexcept {
+	uint32_t crc = 0;
+
+	for ( size_t x = 0; x < n; ++x )
+		crc = x == 0 ? parts[x].crc : combine(crc,parts[x].crc,parts[x].len);
+	return crc;
+}
+
+bool
+Crc32::accelerated() noexcept {
+#ifdef CRC32_CLMUL
+	return crc_fn() == crc_clmul;
+#else
+	return false;
+#endif
+}
+
+// End crc32.cpp
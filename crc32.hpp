@@ -0,0 +1,41 @@
+//////////////////////////////////////////////////////////////////////
+// crc32.hpp -- CRC-32 (gzip polynomial) checksums
+// Date: Mon Oct 19 20:12:48 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// Crc32::update() computes the same CRC-32 as zlib's crc32(), using
+// carry-less multiplication (PCLMULQDQ) to fold 64 bytes at a time
+// when the CPU supports it, selected once at run time. zlib's table
+// driven crc32() handles short buffers, tails and other CPUs.
+//
+// A large buffer can be checksummed in slices, in parallel, and the
+// slice CRCs merged in order with combine() or merge():
+//
+//	Crc32::Part parts[n];	// parts[x] = { slice(buf+off,len), len }
+//	uint32_t crc = Crc32::merge(parts,n);
+///////////////////////////////////////////////////////////////////////
+
+#ifndef CRC32_HPP
+#define CRC32_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Crc32 {
+	struct Part {
+		uint32_t	crc;		// CRC of this slice alone
+		size_t		len;		// Slice length
+	};
+
+	uint32_t update(uint32_t crc,const void *buf,size_t len) noexcept;
+	inline uint32_t slice(const void *buf,size_t len) noexcept { return update(0,buf,len); }
+
+	uint32_t combine(uint32_t crc1,uint32_t crc2,size_t len2) noexcept;
+	uint32_t merge(const Part *parts,size_t n) noexcept;
+
+	bool accelerated() noexcept;	// PCLMULQDQ is being used
+}
+
+#endif // CRC32_HPP
+
+// End crc32.hpp
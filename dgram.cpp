@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////
+// dgram.cpp -- UDP services, batched with recvmmsg(2)/sendmmsg(2)
+// Date: Mon Oct 19 21:58:40 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <errno.h>
+#include <sys/epoll.h>
+
+#include "dgram.hpp"
+
+void
+DgramService::Slots::init(unsigned n,size_t msg_size) {
+
+	msgs.resize(n);
+	iov.resize(n);
+	addrs.resize(n);
+	bufs.resize(n * msg_size);
+
+	for ( unsigned x = 0; x < n; ++x ) {
+		msghdr& hdr = msgs[x].msg_hdr;
+
+		memset(&msgs[x],0,sizeof msgs[x]);
+		iov[x].iov_base = buf(x,msg_size);
+		iov[x].iov_len = msg_size;
+		hdr.msg_name = &addrs[x];
+		hdr.msg_namelen = sizeof addrs[x];
+		hdr.msg_iov = &iov[x];
+		hdr.msg_iovlen = 1;
+	}
+}
+
+DgramService::DgramService(int fd,handler_t *handler,void *arg,unsigned batch,size_t msg_size)
+  : Service(dgram_func,fd), handler(handler), arg(arg), batch(batch ? batch : 1),
+    msg_size(msg_size ? msg_size : default_msg_size), budget(default_budget) {
+
+	rx.init(this->batch,this->msg_size);
+	tx.init(this->batch,this->msg_size);
+	set_tcp(false);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Register the socket with the scheduler, for EPOLLIN:
+//////////////////////////////////////////////////////////////////////
+
+bool
+DgramService::start(Scheduler& scheduler) {
+
+	events() = Events(EPOLLIN);
+	return scheduler.add(socket(),EPOLLIN,this);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Fetch (and so clear) a pending socket error, such as one reported
+// by ICMP for an earlier datagram:
+//////////////////////////////////////////////////////////////////////
+
+int
+DgramService::sock_error() noexcept {
+	int err = 0;
+	socklen_t len = sizeof err;
+
+	getsockopt(socket(),SOL_SOCKET,SO_ERROR,&err,&len);
+	return err;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Queue a datagram to address to. The queue is flushed first when
+// all batch send slots are in use.
+//
+// RETURNS:
+//	true	Queued
+//	false	Longer than msg_size (counted as dropped)
+//////////////////////////////////////////////////////////////////////
+
+bool
+DgramService::send(const u_address& to,socklen_t tolen,const void *data,size_t bytes) {
+
+	if ( bytes > msg_size || tolen > sizeof(u_address) ) {
+		++dropped;
+		return false;
+	}
+	if ( n_tx >= batch )
+		flush();
+
+	msghdr& hdr = tx.msgs[n_tx].msg_hdr;
+
+	memcpy(&tx.addrs[n_tx],&to,tolen);
+	hdr.msg_namelen = tolen;
+	memcpy(tx.buf(n_tx,msg_size),data,bytes);
+	tx.iov[n_tx].iov_len = bytes;
+	++n_tx;
+	return true;
+}
+
+bool
+DgramService::reply(const Datagram& dgram,const void *data,size_t bytes) {
+	return send(*dgram.peer,dgram.peerlen,data,bytes);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Send the queued datagrams with sendmmsg(2). When the socket buffer
+// is full, wait for EPOLLOUT (yielding), with EPOLLIN disabled: the
+// socket is level triggered, and pending datagrams would otherwise
+// wake the service repeatedly. A datagram that fails for any other
+// reason (EMSGSIZE, ENETUNREACH ..) is skipped: UDP gives no delivery
+// guarantee anyway.
+//
+// RETURNS:
+//	The number of datagrams sent
+//////////////////////////////////////////////////////////////////////
+
+unsigned
+DgramService::flush() {
+	unsigned x = 0, n = 0;
+	bool waited = false;
+	int rc;
+
+	while ( x < n_tx ) {
+		rc = ::sendmmsg(socket(),&tx.msgs[x],n_tx - x,MSG_DONTWAIT);
+		if ( rc > 0 ) {
+			x += unsigned(rc);
+			n += unsigned(rc);
+			continue;
+		}
+		if ( rc < 0 && errno == EINTR )
+			continue;
+		if ( rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ) {
+			if ( !waited ) {
+				events().disable_ev(EPOLLIN);
+				events().enable_ev(EPOLLOUT);
+				waited = true;
+			}
+			yield();			// Until writable
+			continue;
+		}
+		++dropped;				// Skip the failing datagram
+		++x;
+	}
+
+	if ( waited ) {
+		events().disable_ev(EPOLLOUT);
+		events().enable_ev(EPOLLIN);
+	}
+	sent += n;
+	n_tx = 0;
+	return n;
+}
+
+CoroutineBase *
+DgramService::dgram_func(CoroutineBase *co) {
+	DgramService& svc = *(DgramService *)co;
+	const int sock = svc.socket();
+	mmsghdr *msgs = svc.rx.msgs.data();
+	unsigned full = 0;			// Full batches this wakeup
+	Datagram dgram;
+	int rc;
+
+	for (;;) {
+		if ( full >= svc.budget ) {
+			++svc.yields;
+			full = 0;
+			svc.yield();			// Let ready services run first
+		}
+
+		for ( unsigned x = 0; x < svc.batch; ++x )
+			msgs[x].msg_hdr.msg_namelen = sizeof(u_address);
+
+		rc = ::recvmmsg(sock,msgs,svc.batch,MSG_DONTWAIT,nullptr);
+		if ( rc <= 0 ) {
+			if ( rc < 0 && errno == EINTR )
+				continue;
+			if ( rc < 0 && errno != EAGAIN && errno != EWOULDBLOCK )
+				svc.sock_error();	// Clear it, or EPOLLERR repeats
+			full = 0;
+			svc.yield();			// Yield to epoll
+			continue;
+		}
+
+		for ( int x = 0; x < rc; ++x ) {
+			const msghdr& hdr = msgs[x].msg_hdr;
+
+			dgram.peer = &svc.rx.addrs[x];
+			dgram.peerlen = hdr.msg_namelen;
+			dgram.data = svc.rx.buf(unsigned(x),svc.msg_size);
+			dgram.size = msgs[x].msg_len < svc.msg_size ? msgs[x].msg_len : svc.msg_size;
+			dgram.truncated = !!(hdr.msg_flags & MSG_TRUNC);
+			svc.handler(svc,dgram,svc.arg);
+		}
+
+		svc.received += unsigned(rc);
+		++svc.batches;
+		if ( svc.n_tx > 0 )
+			svc.flush();			// Replies to this batch
+
+		if ( unsigned(rc) < svc.batch ) {
+			full = 0;
+			svc.yield();			// Likely drained: yield to epoll
+		} else	++full;
+	}
+
+	return nullptr;
+}
+
+// End dgram.cpp
@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////
+// dgram.hpp -- UDP services, batched with recvmmsg(2)/sendmmsg(2)
+// Date: Mon Oct 19 21:58:40 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// A DgramService is the Service of a bound UDP socket (see
+// Sockets::bind_dgram()). Each wakeup it drains the socket with
+// recvmmsg(2), up to batch datagrams per call, and passes each to the
+// handler. Replies queued by the handler (reply(), send()) are sent
+// together with sendmmsg(2) after each batch, or sooner when the send
+// slots fill: a busy socket costs two system calls per batch rather
+// than two per datagram.
+//
+// The socket is level triggered: after budget full batches the
+// service yields, so that other ready services run first. When the
+// socket buffer is full, EPOLLOUT is enabled (and EPOLLIN disabled)
+// until the queued replies are sent.
+//
+// For fan-out across Schedulers (threads), bind one socket per
+// Scheduler with SockOptions::reuse_port (and optionally steer_cpus):
+// the kernel then spreads datagrams by flow across the sockets.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef DGRAM_HPP
+#define DGRAM_HPP
+
+#include <vector>
+
+#include "scheduler.hpp"
+
+class DgramService : public Service {
+public:	struct Datagram {
+		const u_address	*peer;			// Sender's address
+		socklen_t	peerlen;		// Length of *peer
+		const char	*data;			// Payload (valid during the handler call)
+		size_t		size;			// Payload bytes
+		bool		truncated;		// Longer than msg_size: the rest was lost
+	};
+
+	typedef void handler_t(DgramService& svc,const Datagram& dgram,void *arg);
+
+private:
+	struct Slots {
+		std::vector<mmsghdr>	msgs;
+		std::vector<iovec>	iov;
+		std::vector<u_address>	addrs;
+		std::vector<char>	bufs;		// n x msg_size
+
+		void init(unsigned n,size_t msg_size);
+		char *buf(unsigned x,size_t msg_size) noexcept { return bufs.data() + x * msg_size; }
+	};
+
+	handler_t	*handler;		// Called per datagram received
+	void		*arg;			// Handler argument
+	unsigned	batch;			// Datagrams per recvmmsg(2)/sendmmsg(2)
+	size_t		msg_size;		// Largest datagram received or sent
+	unsigned	budget;			// Full batches per wakeup
+	Slots		rx;			// Receive slots
+	Slots		tx;			// Send slots
+	unsigned	n_tx = 0;		// Queued in tx
+
+	static CoroutineBase *dgram_func(CoroutineBase *co);
+	int sock_error() noexcept;
+
+public:	size_t		received = 0;		// Datagrams received
+	size_t		sent = 0;		// Datagrams sent
+	size_t		dropped = 0;		// Datagrams not sent (too long, or send errors)
+	size_t		batches = 0;		// recvmmsg(2) calls returning datagrams
+	size_t		yields = 0;		// Wakeups ended by the budget
+
+	static const unsigned default_batch = 64;
+	static const size_t default_msg_size = 2048;
+	static const unsigned default_budget = 16;
+
+	DgramService(int fd,handler_t *handler,void *arg=nullptr,unsigned batch=default_batch,size_t msg_size=default_msg_size);
+
+	bool start(Scheduler& scheduler);
+	void set_budget(unsigned budget) noexcept { this->budget = budget ? budget : 1; }
+
+	bool reply(const Datagram& dgram,const void *data,size_t bytes);
+	bool send(const u_address& to,socklen_t tolen,const void *data,size_t bytes);
+	unsigned flush();
+};
+
+#endif // DGRAM_HPP
+
+// End dgram.hpp
@@ -0,0 +1,428 @@
+//////////////////////////////////////////////////////////////////////
+// files.cpp -- Static file serving with an open file cache
+// Date: Mon Oct 19 15:02:44 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+
+#include "files.hpp"
+#include "scheduler.hpp"
+#include "response.hpp"
+#include "headers.hpp"
+
+FileInfo::~FileInfo() {
+	if ( fd >= 0 )
+		::close(fd);
+}
+
+FileCache::FileCache(const char *root,size_t max_files,unsigned revalidate)
+: max_files(max_files ? max_files : 1), revalidate(revalidate) {
+	rootfd = ::open(root,O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+}
+
+FileCache::~FileCache() {
+	clear();
+	if ( rootfd >= 0 )
+		::close(rootfd);
+}
+
+void
+FileCache::evict(lru_t::iterator it) {
+	index.erase(Slice((*it)->path.data(),(*it)->path.size()));
+	lru.erase(it);				// fd closes with the last FilePtr
+}
+
+void
+FileCache::clear() {
+	index.clear();
+	lru.clear();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Lookup relpath, opening and caching it when necessary:
+//
+// RETURNS:
+//	0	Success (fp is set)
+//	< 0	-errno (-ENOENT, -EACCES, -EISDIR for non-regular files)
+//////////////////////////////////////////////////////////////////////
+
+int
+FileCache::lookup(const Slice& relpath,time_t now,FilePtr& fp) {
+	auto it = index.find(relpath);
+
+	if ( it != index.end() ) {
+		lru_t::iterator lit = it->second;
+		FileInfo& info = **lit;
+
+		if ( now - info.checked < time_t(revalidate) ) {
+			lru.splice(lru.begin(),lru,lit);	// Most recently used
+			fp = *lit;
+			return 0;
+		}
+
+		struct stat st;
+
+		if ( ::fstatat(rootfd,info.path.c_str(),&st,0) == 0
+		  && st.st_ino == info.st.st_ino && st.st_dev == info.st.st_dev
+		  && st.st_size == info.st.st_size
+		  && st.st_mtim.tv_sec == info.st.st_mtim.tv_sec
+		  && st.st_mtim.tv_nsec == info.st.st_mtim.tv_nsec ) {
+			info.checked = now;
+			lru.splice(lru.begin(),lru,lit);
+			fp = *lit;
+			return 0;
+		}
+		evict(lit);				// Changed or gone: reopen
+	}
+
+	FilePtr info(new FileInfo);
+	char *p;
+
+	info->path.assign(relpath.data,relpath.size);
+	info->fd = ::openat(rootfd,info->path.c_str(),O_RDONLY|O_CLOEXEC|O_NONBLOCK);
+	if ( info->fd < 0 )
+		return -errno;
+	if ( ::fstat(info->fd,&info->st) != 0 )
+		return -errno;
+	if ( !S_ISREG(info->st.st_mode) )
+		return -EISDIR;
+	info->checked = now;
+
+	// Strong ETag from inode, size and modification time:
+	p = info->etag;
+	*p++ = '"';
+	p += fmt_hex(p,uint64_t(info->st.st_ino));
+	*p++ = '-';
+	p += fmt_hex(p,uint64_t(info->st.st_size));
+	*p++ = '-';
+	p += fmt_hex(p,uint64_t(info->st.st_mtim.tv_sec) * 1000000000ull + uint64_t(info->st.st_mtim.tv_nsec));
+	*p++ = '"';
+	info->etag_len = size_t(p - info->etag);
+
+	info->lastmod_len = fmt_http_date(info->lastmod,info->st.st_mtim.tv_sec);
+	info->mime = mime_type(relpath);
+
+	while ( index.size() >= max_files )
+		evict(std::prev(lru.end()));		// Least recently used
+
+	lru.push_front(info);
+	index[Slice(info->path.data(),info->path.size())] = lru.begin();
+	fp = info;
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Content-Type by file name extension:
+//////////////////////////////////////////////////////////////////////
+
+Slice
+FileCache::mime_type(const Slice& path) noexcept {
+	static const struct {
+		const char	*ext;
+		const char	*mime;
+	} types[] = {
+		{ "html",	"text/html; charset=utf-8" },
+		{ "htm",	"text/html; charset=utf-8" },
+		{ "css",	"text/css; charset=utf-8" },
+		{ "js",		"application/javascript" },
+		{ "mjs",	"application/javascript" },
+		{ "json",	"application/json" },
+		{ "txt",	"text/plain; charset=utf-8" },
+		{ "xml",	"application/xml" },
+		{ "svg",	"image/svg+xml" },
+		{ "png",	"image/png" },
+		{ "jpg",	"image/jpeg" },
+		{ "jpeg",	"image/jpeg" },
+		{ "gif",	"image/gif" },
+		{ "webp",	"image/webp" },
+		{ "ico",	"image/x-icon" },
+		{ "woff",	"font/woff" },
+		{ "woff2",	"font/woff2" },
+		{ "wasm",	"application/wasm" },
+		{ "pdf",	"application/pdf" },
+		{ "gz",		"application/gzip" },
+		{ "zip",	"application/zip" },
+		{ "mp4",	"video/mp4" },
+	};
+	const char *e = path.end(), *p = e;
+
+	while ( p > path.data && p[-1] != '.' && p[-1] != '/' )
+		--p;
+	if ( p > path.data && p[-1] == '.' ) {
+		Slice ext(p,size_t(e - p));
+
+		for ( auto& t : types )
+			if ( ext.iequals(t.ext) )
+				return Slice(t.mime);
+	}
+	return Slice("application/octet-stream");
+}
+
+//////////////////////////////////////////////////////////////////////
+// A decoded relative path is safe when it has no NUL bytes, is not
+// absolute, and has no "." or ".." segments:
+//////////////////////////////////////////////////////////////////////
+
+bool
+StaticFiles::safe_path(const Slice& relpath) noexcept {
+	const char *p = relpath.data, *e = relpath.end();
+
+	if ( memchr(p,0,relpath.size) || (p < e && *p == '/') )
+		return false;
+
+	while ( p < e ) {
+		const char *s = p;
+
+		while ( p < e && *p != '/' )
+			++p;
+		if ( (p - s == 1 && s[0] == '.') || (p - s == 2 && s[0] == '.' && s[1] == '.') )
+			return false;
+		if ( p < e )
+			++p;				// Skip '/'
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Does the If-None-Match list match etag (weak comparison)?
+//////////////////////////////////////////////////////////////////////
+
+static bool
+etag_match(const Slice& list,const Slice& etag) noexcept {
+	const char *p = list.data, *e = list.end();
+
+	while ( p < e ) {
+		while ( p < e && (*p == ' ' || *p == '\t' || *p == ',') )
+			++p;
+		const char *s = p;
+		while ( p < e && *p != ',' )
+			++p;
+		const char *t = p;
+		while ( t > s && (t[-1] == ' ' || t[-1] == '\t') )
+			--t;
+
+		Slice tag(s,size_t(t - s));
+
+		if ( tag.equals("*") )
+			return true;
+		if ( tag.starts_with("W/") ) {
+			tag.data += 2;
+			tag.size -= 2;
+		}
+		if ( !tag.empty() && tag.equals(etag.data,etag.size) )
+			return true;
+	}
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Parse a single byte range "bytes=first-last", "bytes=first-" or
+// "bytes=-suffix" against a representation of size bytes:
+//
+// RETURNS:
+//	1	Satisfiable: first and last are set
+//	0	Ignore the Range header (malformed or multiple ranges)
+//	-1	Unsatisfiable (416)
+//////////////////////////////////////////////////////////////////////
+
+static int
+parse_range(const Slice& spec,uint64_t size,uint64_t& first,uint64_t& last) noexcept {
+	const char *p = spec.data, *e = spec.end();
+	bool have_first = false, have_last = false;
+	uint64_t a = 0, b = 0;
+
+	auto num = [&p,e](uint64_t& v) -> bool {
+		bool digits = false;
+
+		for ( v = 0; p < e && *p >= '0' && *p <= '9'; ++p, digits = true ) {
+			if ( v > (~uint64_t(0) - 9) / 10 )
+				return false;		// Overflow
+			v = v * 10 + uint64_t(*p - '0');
+		}
+		return digits;
+	};
+
+	if ( spec.size < 6 || strncasecmp(p,"bytes=",6) != 0 )
+		return 0;
+	p += 6;
+	while ( p < e && *p == ' ' )
+		++p;
+	if ( memchr(p,',',size_t(e - p)) )
+		return 0;			// Multiple ranges: send it all
+
+	have_first = num(a);
+	if ( p >= e || *p++ != '-' )
+		return 0;
+	have_last = num(b);
+	while ( p < e && *p == ' ' )
+		++p;
+	if ( p != e || (!have_first && !have_last) )
+		return 0;
+
+	if ( !have_first ) {			// Suffix range
+		if ( b == 0 || size == 0 )
+			return -1;
+		first = b >= size ? 0 : size - b;
+		last = size - 1;
+		return 1;
+	}
+	if ( have_last && b < a )
+		return 0;			// Invalid: ignore
+	if ( a >= size )
+		return -1;
+	first = a;
+	last = have_last && b < size ? b : size - 1;
+	return 1;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Serve relpath (already percent-decoded) for a GET or HEAD request.
+// The response, including file content, is written to sock.
+//
+// RETURNS:
+//	< 0	I/O error (-errno): the connection should be closed
+//	> 0	HTTP status code sent
+//////////////////////////////////////////////////////////////////////
+
+int
+StaticFiles::serve(Service& svc,int sock,const Slice& method,const Slice& relpath,
+  const HeaderMap& headers,Response& resp,const DateCache& date,bool keep_alive) {
+	const Slice connection(keep_alive ? "Keep-Alive" : "Close");
+	bool headf = method.equals("HEAD");
+	std::string index_path;
+	Slice path(relpath);
+	const Slice *pv;
+	FilePtr fp;
+	int status, rc;
+
+	auto simple = [&](int code) -> int {
+		resp.status(code).date(date).header(H_Connection,connection);
+		if ( code == 405 )
+			resp.header(H_Allow,"GET, HEAD");
+		resp.finish();
+
+		int rc = svc.write(sock,resp);
+		return rc < 0 ? rc : code;
+	};
+
+	if ( !headf && !method.equals("GET") )
+		return simple(405);
+	if ( !safe_path(path) )
+		return simple(403);
+
+	if ( path.empty() || path.data[path.size-1] == '/' ) {
+		index_path.assign(path.data,path.size);
+		index_path += "index.html";
+		path = Slice(index_path.data(),index_path.size());
+	}
+
+	rc = cache.lookup(path,::time(nullptr),fp);
+	if ( rc == -ENOENT || rc == -ENOTDIR )
+		return simple(404);
+	if ( rc < 0 )
+		return simple(403);
+
+	const FileInfo& info = *fp;
+	uint64_t size = uint64_t(info.st.st_size), first = 0, last = size - 1;
+
+	//////////////////////////////////////////////////////////////
+	// Conditional request: If-None-Match takes precedence
+	//////////////////////////////////////////////////////////////
+
+	bool not_modified = false;
+
+	if ( (pv = headers.find(H_IfNoneMatch)) != nullptr ) {
+		not_modified = etag_match(*pv,info.etag_value());
+	} else if ( (pv = headers.find(H_IfModifiedSince)) != nullptr ) {
+		time_t since;
+
+		if ( parse_http_date(*pv,since) )
+			not_modified = info.st.st_mtim.tv_sec <= since;
+	}
+
+	if ( not_modified ) {
+		resp.status(304)
+			.date(date)
+			.header(H_ETag,info.etag_value())
+			.header(H_LastModified,info.lastmod_value())
+			.header(H_Connection,connection)
+			.end_headers();
+		rc = svc.write(sock,resp);
+		return rc < 0 ? rc : 304;
+	}
+
+	//////////////////////////////////////////////////////////////
+	// Range, unless If-Range names another version
+	//////////////////////////////////////////////////////////////
+
+	status = 200;
+	if ( (pv = headers.find(H_Range)) != nullptr ) {
+		const Slice *pif = headers.find(H_IfRange);
+
+		if ( !pif || pif->equals(info.etag,info.etag_len) || pif->equals(info.lastmod,info.lastmod_len) ) {
+			switch ( parse_range(*pv,size,first,last) ) {
+			case 1:
+				status = 206;
+				break;
+			case -1:
+				{
+					char buf[40], *p = buf;
+
+					memcpy(p,"bytes */",8);
+					p += 8;
+					p += fmt_uint(p,size);
+					resp.status(416)
+						.date(date)
+						.header(H_ContentRange,Slice(buf,size_t(p - buf)))
+						.header(H_Connection,connection)
+						.finish();
+					rc = svc.write(sock,resp);
+					return rc < 0 ? rc : 416;
+				}
+			default:
+				break;
+			}
+		}
+	}
+
+	uint64_t count = size ? last - first + 1 : 0;
+
+	resp.status(status)
+		.date(date)
+		.header(H_ContentType,info.mime)
+		.header(H_ETag,info.etag_value())
+		.header(H_LastModified,info.lastmod_value())
+		.header(H_AcceptRanges,"bytes");
+
+	if ( status == 206 ) {
+		char buf[72], *p = buf;
+
+		memcpy(p,"bytes ",6);
+		p += 6;
+		p += fmt_uint(p,first);
+		*p++ = '-';
+		p += fmt_uint(p,last);
+		*p++ = '/';
+		p += fmt_uint(p,size);
+		resp.header(H_ContentRange,Slice(buf,size_t(p - buf)));
+	}
+
+	resp.header(H_ContentLength,count)
+		.header(H_Connection,connection)
+		.end_headers();
+
+	rc = svc.write(sock,resp,!headf && count > 0);
+	if ( rc < 0 )
+		return rc;
+	if ( !headf && count > 0 ) {
+		rc = svc.send_file(sock,info.fd,off_t(first),size_t(count));
+		if ( rc < 0 )
+			return rc;
+	}
+	return status;
+}
+
+// End files.cpp
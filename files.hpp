@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////
+// files.hpp -- Static file serving with an open file cache
+// Date: Mon Oct 19 15:02:44 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// FileCache keeps an LRU of open file descriptors with their stat(2)
+// results and precomputed ETag / Last-Modified values, relative to a
+// document root. Entries are revalidated with fstatat(2) at most once
+// per revalidate seconds. An entry evicted while a send is in progress
+// stays open until the last FilePtr is released.
+//
+// StaticFiles answers GET/HEAD requests from a FileCache, including
+// conditional (304) and single Range (206) requests, sending content
+// with sendfile(2) so it never passes through HttpBuf.
+//
+// Neither class is thread safe: use one per Scheduler.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef FILES_HPP
+#define FILES_HPP
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "utility.hpp"
+
+class Service;
+class Response;
+class DateCache;
+class HeaderMap;
+
+struct FileInfo {
+	std::string	path;			// Path relative to root (cache key)
+	int		fd = -1;		// Open file
+	struct stat	st;			// fstat(2) results
+	time_t		checked = 0;		// When st was last validated
+	char		etag[48];		// Quoted strong ETag
+	size_t		etag_len = 0;
+	char		lastmod[32];		// Last-Modified value
+	size_t		lastmod_len = 0;
+	Slice		mime;			// Content-Type
+
+	~FileInfo();
+
+	Slice etag_value() const noexcept	{ return Slice(etag,etag_len); }
+	Slice lastmod_value() const noexcept	{ return Slice(lastmod,lastmod_len); }
+};
+
+typedef std::shared_ptr<FileInfo> FilePtr;
+
+class FileCache {
+	struct s_slicehash {
+		size_t operator()(const Slice& s) const noexcept { return size_t(casehash(s.data,s.size)); }
+	};
+	struct s_sliceeq {
+		bool operator()(const Slice& a,const Slice& b) const noexcept { return a.equals(b.data,b.size); }
+	};
+	typedef std::list<FilePtr> lru_t;
+
+	int		rootfd = -1;		// Document root directory
+	size_t		max_files;		// Open descriptors kept
+	unsigned	revalidate;		// Seconds between fstatat(2) checks
+	lru_t		lru;			// Most recently used first
+	std::unordered_map<Slice,lru_t::iterator,s_slicehash,s_sliceeq> index; // Keys reference FileInfo::path
+
+	void evict(lru_t::iterator it);
+
+public:	FileCache(const char *root,size_t max_files=256,unsigned revalidate=1);
+	~FileCache();
+
+	bool ok() const noexcept		{ return rootfd >= 0; }
+	size_t size() const noexcept		{ return index.size(); }
+
+	int lookup(const Slice& relpath,time_t now,FilePtr& fp);
+	void clear();
+
+	static Slice mime_type(const Slice& path) noexcept;
+};
+
+class StaticFiles {
+	FileCache	cache;
+
+public:	StaticFiles(const char *root,size_t max_files=256,unsigned revalidate=1)
+		: cache(root,max_files,revalidate) {}
+
+	bool ok() const noexcept		{ return cache.ok(); }
+	FileCache& files() noexcept		{ return cache; }
+
+	static bool safe_path(const Slice& relpath) noexcept;
+
+	int serve(Service& svc,int sock,const Slice& method,const Slice& relpath,
+		const HeaderMap& headers,Response& resp,const DateCache& date,bool keep_alive);
+};
+
+#endif // FILES_HPP
+
+// End files.hpp
@@ -12,10 +12,12 @@
 #include <assert.h>
 
 #include "gzip.hpp"
+#include "crc32.hpp"
 
-Zlib::Zlib(size_t inbufsiz,size_t outbufsiz, write_cb_t write_cb) : write_cb(write_cb) {
+Zlib::Zlib(size_t inbufsiz,size_t outbufsiz,write_cb_t write_cb,Slab *slab) : write_cb(write_cb) {
 
 	gzip_wbits = 9;
+	level = Z_BEST_SPEED;
 
 	insize = inbufsiz;
 	outsize = outbufsiz;
@@ -39,9 +41,15 @@ Zlib::Zlib(size_t inbufsiz,size_t outbufsiz, write_cb_t write_cb) : write_cb(wri
 	zstream.total_in = 0;
 	zstream.total_out = 0;
 
-	zstream.zalloc = Z_NULL;
-	zstream.zfree = Z_NULL;
-	zstream.opaque = Z_NULL;
+	if ( slab ) {
+		zstream.zalloc = zalloc;
+		zstream.zfree = zfree;
+		zstream.opaque = slab;
+	} else	{
+		zstream.zalloc = Z_NULL;
+		zstream.zfree = Z_NULL;
+		zstream.opaque = Z_NULL;
+	}
 
 	zstream.msg = 0;
 	zstream.data_type = Z_BINARY;
@@ -52,11 +60,28 @@ Zlib::Zlib(size_t inbufsiz,size_t outbufsiz, write_cb_t write_cb) : write_cb(wri
 }
 
 Zlib::~Zlib() {
+	if ( mode == Compress )
+		deflateEnd(&zstream);		// Abandoned before finish()
+	else if ( mode == Decompress )
+		inflateEnd(&zstream);
 	delete []inbuf;
 	delete []outbuf;
 }
 
-void
+//////////////////////////////////////////////////////////////////////
+// compress(), decompress() and finish() return:
+//
+//	Z_OK		Success
+//	Z_STREAM_END	decompress(): the end of the compressed stream was
+//			reached. For gzip, input following a member is the
+//			next member (RFC 1952 concatenation), decoded as
+//			part of the same stream; otherwise it is ignored.
+//	Aborted		abort() was called by the write callback
+//	< 0		zlib error: Z_DATA_ERROR for corrupt or truncated
+//			input, Z_MEM_ERROR etc.
+//////////////////////////////////////////////////////////////////////
+
+int
 Zlib::compress(void *buf,size_t bytes,void *arg) {
         unsigned char *ubuf = (unsigned char *)buf;
         unsigned char *unext = 0;
@@ -65,30 +90,38 @@ Zlib::compress(void *buf,size_t bytes,void *arg) {
         if ( mode == Gzip ) {
                 rc = deflateInit2(
                         &zstream,
-                        Z_BEST_SPEED,		// Low CPU please
+                        level,			// Z_BEST_SPEED unless set_level()
                         Z_DEFLATED,		// Method (must be Z_DEFLATED)
                         16 + gzip_wbits,	// windowBits
                         8,			// Memory level
                         Z_DEFAULT_STRATEGY);
-                assert(rc == Z_OK);
+                if ( rc != Z_OK )
+                        return rc;
                 mode = Compress;
+                endf = abortf = false;
 
         } else if ( mode == Neither ) {
-                rc = deflateInit(&zstream,Z_BEST_SPEED);
-                assert(rc == Z_OK);
-                (void)rc;
+                rc = deflateInit(&zstream,level);
+                if ( rc != Z_OK )
+                        return rc;
                 mode = Compress;
+                endf = abortf = false;
         }
 
-        assert(mode == Compress);
+        if ( mode != Compress )
+                return Z_STREAM_ERROR;
 
         for (;;) {
-                if ( zstream.avail_out <= out_threshold )
+                if ( zstream.avail_out <= out_threshold ) {
                         write_callback(arg);
+                        if ( abortf )
+                                return Aborted;
+                }
 
                 if ( zstream.avail_in > 0 ) {
                         rc = deflate(&zstream,Z_NO_FLUSH);
-                        assert( rc == Z_OK || rc == Z_STREAM_END );
+                        if ( rc != Z_OK && rc != Z_BUF_ERROR )
+                                return rc;
 
                         if ( zstream.avail_in <= 0 ) {
                                 zstream.next_in = (Bytef *)inbuf;
@@ -114,9 +147,10 @@ Zlib::compress(void *buf,size_t bytes,void *arg) {
                         bytes -= bufbytes;
                 }
         }
+        return Z_OK;
 }
 
-void
+int
 Zlib::decompress(void *buf,size_t bytes,void *arg) {
         unsigned char *ubuf = (unsigned char *)buf;
         unsigned char *unext = 0;
@@ -125,26 +159,51 @@ Zlib::decompress(void *buf,size_t bytes,void *arg) {
         if ( mode == Gzip ) {
 		// Use max (15) so any compressed can be decompressed
                 rc = inflateInit2(&zstream,16+15);
-                assert(rc == Z_OK);
+                if ( rc != Z_OK )
+                        return rc;
                 mode = Decompress;
+                endf = abortf = false;
+                gzipf = true;
         }
 
         if ( mode == Neither ) {
                 rc = inflateInit(&zstream);
-                assert(rc == Z_OK);
-                (void)rc;
+                if ( rc != Z_OK )
+                        return rc;
                 mode = Decompress;
+                endf = abortf = false;
         }
 
-        assert(mode == Decompress);
+        if ( mode != Decompress )
+                return Z_STREAM_ERROR;
+        if ( endf ) {
+                if ( !gzipf || bytes <= 0 )
+                        return Z_STREAM_END;    // Trailing input is ignored
+                next_member();
+        }
 
         for (;;) {
-                if ( zstream.avail_out <= out_threshold )
+                if ( zstream.avail_out <= out_threshold ) {
                         write_callback(arg);
+                        if ( abortf )
+                                return Aborted;
+                }
 
                 if ( zstream.avail_in > 0 ) {
                         rc = inflate(&zstream,Z_NO_FLUSH);
-                        assert( rc == Z_OK || rc == Z_STREAM_END );
+                        if ( rc == Z_STREAM_END ) {
+                                write_callback(arg);
+                                if ( abortf )
+                                        return Aborted;
+                                if ( gzipf && (zstream.avail_in > 0 || bytes > 0) ) {
+                                        next_member();  // Concatenated gzip member
+                                        continue;
+                                }
+                                endf = true;
+                                return Z_STREAM_END;
+                        }
+                        if ( rc != Z_OK )
+                                return rc == Z_NEED_DICT ? Z_DATA_ERROR : rc;
 
                         if ( zstream.avail_in <= 0 ) {
                                 zstream.next_in = (Bytef *)inbuf;
@@ -157,8 +216,6 @@ Zlib::decompress(void *buf,size_t bytes,void *arg) {
 
                 unext = (unsigned char *)zstream.next_in + zstream.avail_in;
 
-                unext = (unsigned char *)zstream.next_in + zstream.avail_in;
-
                 if ( unext < endbuf ) {
 			// We can stuff more bytes into the in buffer
                         size_t bufbytes = endbuf - unext;
@@ -173,42 +230,221 @@ Zlib::decompress(void *buf,size_t bytes,void *arg) {
                         bytes -= bufbytes;
                 }
         }
+        return Z_OK;
 }
 
-void
+int
 Zlib::finish(void *arg) {
         int rc = Z_OK;
 
-        assert(mode != Neither);
+        if ( mode == Gzip || mode == Neither ) {
+                // No input was given
+                if ( poolx == ZlibPool::GzipInflate )
+                        return Z_DATA_ERROR;    // Empty compressed stream
+                rc = compress(nullptr,0,arg);   // Empty compressed stream
+                if ( rc != Z_OK )
+                        return rc;
+        }
+
+        if ( endf )
+                rc = Z_STREAM_END;
 
         if ( zstream.avail_out < outsize )
                 write_callback(arg);
 
-        while ( rc != Z_STREAM_END && zstream.avail_in > 0 ) {
+        while ( rc != Z_STREAM_END && zstream.avail_in > 0 && !abortf ) {
                 if ( zstream.avail_out > 0 ) {
                         if ( mode == Compress )
                                 rc = deflate(&zstream,Z_NO_FLUSH);
                         else    rc = inflate(&zstream,Z_NO_FLUSH);
-                        assert(rc == Z_OK || rc == Z_STREAM_END);
+                        if ( rc == Z_STREAM_END && gzipf && zstream.avail_in > 0 ) {
+                                write_callback(arg);
+                                next_member();  // Concatenated gzip member
+                                rc = Z_OK;
+                                continue;
+                        }
+                        if ( rc != Z_OK && rc != Z_STREAM_END )
+                                break;
                 }
                 if ( zstream.avail_out < outsize )
                         write_callback(arg);
         }
 
-        while ( rc != Z_STREAM_END ) {
+        while ( (rc == Z_OK || rc == Z_BUF_ERROR) && !abortf ) {
                 if ( mode == Compress )
                         rc = deflate(&zstream,Z_FINISH);
                 else    rc = inflate(&zstream,Z_FINISH);
-                assert(rc == Z_OK || rc == Z_STREAM_END);
 
+                if ( rc == Z_BUF_ERROR && zstream.avail_out > 0 ) {
+                        rc = Z_DATA_ERROR;      // Truncated input
+                        break;
+                }
                 if ( zstream.avail_out < outsize )
                         write_callback(arg);
         }
 
+        if ( abortf )
+                rc = Aborted;
+        else if ( rc == Z_STREAM_END )
+                rc = Z_OK;
+        else if ( rc == Z_NEED_DICT )
+                rc = Z_DATA_ERROR;
+        endf = true;
+
+        if ( keepf )
+                return rc;              // Pooled: reset() before reuse
+
         if ( mode == Compress )
-                rc = deflateEnd(&zstream);
-        else    rc = inflateEnd(&zstream);
-        assert(rc == Z_OK);
+                deflateEnd(&zstream);
+        else    inflateEnd(&zstream);
+        mode = Neither;
+        return rc;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Make an initialized stream ready for a new compression or
+// decompression, keeping its settings and zlib state allocations:
+//////////////////////////////////////////////////////////////////////
+
+void
+Zlib::reset() {
+
+	if ( mode == Compress )
+		deflateReset(&zstream);
+	else if ( mode == Decompress )
+		inflateReset(&zstream);
+
+	zstream.next_in = (Bytef *)inbuf;
+	zstream.avail_in = 0;
+	zstream.next_out = (Bytef *)outbuf;
+	zstream.avail_out = outsize;
+	endf = abortf = false;
+	prior_in = prior_out = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Start decoding the next member of a concatenated gzip stream. The
+// totals carry on, so that limits apply to the stream as a whole.
+//////////////////////////////////////////////////////////////////////
+
+void
+Zlib::next_member() {
+
+	prior_in += zstream.total_in;
+	prior_out += zstream.total_out;
+	inflateReset(&zstream);			// Keeps next_in/avail_in
+	if ( zstream.avail_in <= 0 ) {
+		zstream.next_in = (Bytef *)inbuf;
+		zstream.avail_in = 0;
+	}
+	endf = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set the compression level: applies to the next compression, or to
+// a reset() stream that has not been given input yet.
+//////////////////////////////////////////////////////////////////////
+
+void
+Zlib::set_level(int level) {
+
+	if ( level == this->level )
+		return;
+	this->level = level;
+	if ( mode == Compress )
+		deflateParams(&zstream,level,Z_DEFAULT_STRATEGY);
+}
+
+voidpf
+Zlib::zalloc(voidpf opaque,uInt items,uInt size) {
+	void *p = ((Slab *)opaque)->alloc(size_t(items) * size);
+
+	return p ? p : Z_NULL;
+}
+
+void
+Zlib::zfree(voidpf opaque,voidpf address) {
+	((Slab *)opaque)->free(address);
+}
+
+void
+Zlib::Release::operator()(Zlib *zlib) const noexcept {
+
+	if ( zlib->pool )
+		zlib->pool->put(zlib);
+	else	delete zlib;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Zlib stream pool
+//////////////////////////////////////////////////////////////////////
+
+ZlibPool::ZlibPool(size_t max_idle) : max_idle(max_idle) {
+	for ( auto& list : idle )
+		list.reserve(max_idle);		// put() does not allocate
+}
+
+ZlibPool::~ZlibPool() {
+	for ( auto& list : idle ) {
+		for ( Zlib *zlib : list ) {
+			zlib->pool = nullptr;
+			zlib->keepf = false;
+			delete zlib;		// Ends the stream into slab
+		}
+		list.clear();
+	}
+}
+
+ZlibPool&
+ZlibPool::local() {
+	static thread_local ZlibPool pool;
+
+	return pool;
+}
+
+ZlibPtr
+ZlibPool::get(Kind kind,Zlib::write_cb_t write_cb,int level) {
+	std::vector<Zlib*>& list = idle[kind];
+	Zlib *zlib;
+
+	if ( !list.empty() ) {
+		zlib = list.back();
+		list.pop_back();
+		zlib->reset();
+		++reused;
+	} else	{
+		zlib = new Zlib(inbuf_size,outbuf_size,write_cb,&slab);
+		zlib->gzip_init(15);		// Initialized on first use
+		zlib->pool = this;
+		zlib->poolx = int(kind);
+		zlib->keepf = true;
+		++created;
+	}
+	if ( kind == GzipDeflate )
+		zlib->set_level(level);
+	zlib->write_cb = write_cb;
+	return ZlibPtr(zlib);
+}
+
+void
+ZlibPool::put(Zlib *zlib) noexcept {
+	std::vector<Zlib*>& list = idle[zlib->poolx];
+
+	if ( list.size() >= max_idle ) {
+		zlib->keepf = false;
+		delete zlib;
+		return;
+	}
+	list.push_back(zlib);
+}
+
+//////////////////////////////////////////////////////////////////////
+// CRC-32 of a buffer, as used by gzip (see Crc32::update()):
+//////////////////////////////////////////////////////////////////////
+
+uint32_t
+Zlib::crc32(void *buf,size_t buflen) {
+	return Crc32::update(0,buf,buflen);
 }
 
 void
@@ -222,12 +458,33 @@ Zlib::write_callback(void *arg) {
         }
 }
 
+//////////////////////////////////////////////////////////////////////
+// The output of a Gzip helper: the stream, or nullptr (and the stream
+// deleted) when zlib failed, rather than partial output.
+//////////////////////////////////////////////////////////////////////
+
+static std::stringstream *
+result(std::stringstream& otstr,int rc) {
+
+	if ( rc != Z_OK ) {
+		delete &otstr;
+		return nullptr;
+	}
+	return &otstr;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Compress to gzip compatible format:
 //
 // Notes:
 //	wbits must be >= 9 (default). The higher this value (15 max),
 //	the more CPU effort is required. See zlib deflateInit2().
+//	Streams come from the thread's ZlibPool, which uses 15 for
+//	all streams, so wbits is only checked.
+//
+// RETURNS:
+//	A new std::stringstream, or nullptr if zlib failed (corrupt or
+//	truncated input when decompressing)
 //////////////////////////////////////////////////////////////////////
 
 std::stringstream *
@@ -236,6 +493,7 @@ Gzip::compress(std::stringstream& instr,int wbits) {
 	char buf[16*1024];					// instr buffer
 	std::streamsize isize = instr.tellp();			// Instream content length
 	std::streamsize sn;					// Read length from instr
+	int rc = Z_OK;						// Zlib return code
 	
 	assert(wbits >= 9);					// See zlib deflateInit2() arg windowBits
 	
@@ -246,17 +504,17 @@ Gzip::compress(std::stringstream& instr,int wbits) {
 		outstr.write((char *)buf,bytes);
 	};
 	
-	Zlib zlib(8*1024,8*1024,callback);			// Configure compression object zlib
-	zlib.gzip_init(10);					// Use gzip format
+	ZlibPtr zlib = ZlibPool::local().get(ZlibPool::GzipDeflate,callback);
 	instr.seekg(0);						// Rewind the read pointer in instr
 	
-	while ( instr.tellg() < isize ) {			// While not fully read..
+	while ( rc == Z_OK && instr.tellg() < isize ) {		// While not fully read..
 		sn = instr.readsome(buf,sizeof buf);		// Read up to sizeof buf chars
 		assert(sn > 0);
-		zlib.compress(buf,sn,&otstr);			// Compress what we read
+		rc = zlib->compress(buf,sn,&otstr);		// Compress what we read
 	}
-	zlib.finish(&otstr);					// Push final bytes out to otstr
-	return &otstr;						// Return new std::stringstream
+	if ( rc == Z_OK )
+		rc = zlib->finish(&otstr);			// Push final bytes out to otstr
+	return result(otstr,rc);				// New std::stringstream, or nullptr
 }
 
 std::stringstream *
@@ -265,6 +523,7 @@ Gzip::decompress(std::stringstream& instr,int wbits) {
 	char buf[16*1024];					// instr buffer
 	std::streamsize isize = instr.tellp();			// Instream content length
 	std::streamsize sn;					// Read length from instr
+	int rc = Z_OK;						// Zlib return code
 	
 	assert(wbits >= 9);					// See zlib deflateInit2() arg windowBits
 	
@@ -275,18 +534,17 @@ Gzip::decompress(std::stringstream& instr,int wbits) {
 		outstr.write((char *)buf,bytes);
 	};
 	
-	Zlib zlib(8*1024,8*1024,callback);			// Configure compression object zlib
-	
-	zlib.gzip_init(wbits);					// Use gzip format
+	ZlibPtr zlib = ZlibPool::local().get(ZlibPool::GzipInflate,callback);
 	instr.seekg(0);						// Rewind the read pointer in instr
 	
-	while ( instr.tellg() < isize ) {			// While not fully read..
+	while ( (rc == Z_OK || rc == Z_STREAM_END) && instr.tellg() < isize ) {
 		sn = instr.readsome(buf,sizeof buf);		// Read up to sizeof buf chars
 		assert(sn > 0);
-		zlib.decompress(buf,sn,&otstr);			// Compress what we read
+		rc = zlib->decompress(buf,sn,&otstr);		// Decompress what we read
 	}
-	zlib.finish(&otstr);					// Push final bytes out to otstr
-	return &otstr;						// Return new std::stringstream
+	if ( rc == Z_OK || rc == Z_STREAM_END )
+		rc = zlib->finish(&otstr);			// Push final bytes out to otstr
+	return result(otstr,rc);				// New std::stringstream, or nullptr
 }
 	
 std::stringstream *
@@ -302,12 +560,50 @@ Gzip::decompress(const char *data,size_t bytes,int wbits) {
 		outstr.write((char *)buf,bytes);
 	};
 	
-	Zlib zlib(8*1024,8*1024,callback);			// Configure compression object zlib
-	
-	zlib.gzip_init(wbits);					// Use gzip format
-	zlib.decompress((void*)data,bytes,&otstr);
-	zlib.finish(&otstr);					// Push final bytes out to otstr
-	return &otstr;						// Return new std::stringstream
+	ZlibPtr zlib = ZlibPool::local().get(ZlibPool::GzipInflate,callback);
+	int rc = zlib->decompress((void*)data,bytes,&otstr);
+
+	if ( rc == Z_OK || rc == Z_STREAM_END )
+		rc = zlib->finish(&otstr);			// Push final bytes out to otstr
+	return result(otstr,rc);				// New std::stringstream, or nullptr
 }
 	
+//////////////////////////////////////////////////////////////////////
+// Is a response body worth compressing? Bodies known to be smaller
+// than min_size gain little over the added CPU and gzip overhead, and
+// media and archive types are already compressed. content_length is
+// negative when not known in advance.
+//////////////////////////////////////////////////////////////////////
+
+bool
+Gzip::compressible(const Slice& content_type,long content_length,size_t min_size) noexcept {
+	static const char *compressed[] = {
+		"image/",		// Except image/svg+xml (below)
+		"audio/",
+		"video/",
+		"font/woff",		// woff and woff2
+		"application/gzip",
+		"application/x-gzip",
+		"application/zip",
+		"application/zstd",
+		"application/x-bzip2",
+		"application/x-xz",
+		"application/x-7z-compressed",
+		"application/pdf",
+		"application/octet-stream",
+	};
+
+	if ( content_length >= 0 && size_t(content_length) < min_size )
+		return false;
+	if ( content_type.size >= 13 && !strncasecmp(content_type.data,"image/svg+xml",13) )
+		return true;
+	for ( auto prefix : compressed ) {
+		size_t n = strlen(prefix);
+
+		if ( content_type.size >= n && !strncasecmp(content_type.data,prefix,n) )
+			return false;
+	}
+	return true;
+}
+
 // End gzip.cpp
@@ -8,13 +8,23 @@
 
 #include <stdint.h>
 #include "zlib.h"
+#include "utility.hpp"
 
 #include <string>
 #include <sstream>
+#include <vector>
+#include <memory>
+
+#include "arena.hpp"
+
+class ZlibPool;
 
 class Zlib {
-	typedef void (*write_cb_t)(void *buf,size_t bytes,void *arg);
+	friend ZlibPool;
+
+public:	typedef void (*write_cb_t)(void *buf,size_t bytes,void *arg);
 
+private:
 	unsigned char	*inbuf;		// Allocated input buffer
 	size_t		insize;		// Input buffer size
 	unsigned char	*endbuf;	// Points one byte past end of input buffer
@@ -26,6 +36,16 @@ class Zlib {
 	size_t		out_threshold;	// Threshold for write callback
 
 	int		gzip_wbits;	// windowBits for defaultInit2()
+	int		level;		// Compression level
+
+	ZlibPool	*pool = nullptr;// Pool this stream returns to
+	int		poolx = -1;	// Pool list index
+	bool		keepf = false;	// finish() keeps the stream for reset()
+	bool		endf = false;	// End of stream reached (or finished)
+	bool		abortf = false;	// abort() was called
+	bool		gzipf = false;	// Decompressing gzip: members may follow
+	size_t		prior_in = 0;	// total_in of earlier gzip members
+	size_t		prior_out = 0;	// total_out of earlier gzip members
 
 	enum Mode {
 		Compress,
@@ -40,23 +60,81 @@ public:
 protected:
 	void init(Mode arg_mode,size_t inbufsize,size_t outbufsize);
 	void write_callback(void *arg);
+	void next_member();
+
+	static voidpf zalloc(voidpf opaque,uInt items,uInt size);
+	static void zfree(voidpf opaque,voidpf address);
 
-public:	Zlib(size_t inbufsiz,size_t outbufsize,write_cb_t write_cb);
+public:	Zlib(size_t inbufsiz,size_t outbufsize,write_cb_t write_cb,Slab *slab=nullptr);
 	~Zlib();
 
+	struct Release {
+		void operator()(Zlib *zlib) const noexcept;	// Back to pool, or delete
+	};
+
+	void reset();
+	void set_level(int level);
+
 	void gzip_init(int wbits=9)     { mode = Gzip; gzip_wbits=wbits; } // Optional: Use gzip format
 
-	void compress(void *buf,size_t bytes,void *arg);
-	void decompress(void *buf,size_t bytes,void *arg);
-	void finish(void *arg);
+	static const int Aborted = -100;	// Return code after abort()
+
+	int compress(void *buf,size_t bytes,void *arg);
+	int decompress(void *buf,size_t bytes,void *arg);
+	int finish(void *arg);
+	void abort() noexcept		{ abortf = true; }	// From write_cb: stop early
+
+	size_t total_in() const noexcept	{ return prior_in + zstream.total_in; }
+	size_t total_out() const noexcept	{ return prior_out + zstream.total_out; }
 	
 	static uint32_t crc32(void *buf,size_t buflen);
 };
 
+typedef std::unique_ptr<Zlib,Zlib::Release> ZlibPtr;
+
+//////////////////////////////////////////////////////////////////////
+// Pool of initialized Zlib streams. A stream released to the pool is
+// kept initialized, and reused after deflateReset()/inflateReset()
+// rather than paying for deflateInit2()/deflateEnd() and the buffer
+// allocations each time. zlib's internal state is allocated from the
+// pool's Slab. Pools are not thread safe: local() returns the calling
+// thread's pool, which is the pool of the Scheduler on that thread.
+//////////////////////////////////////////////////////////////////////
+
+class ZlibPool {
+public:	enum Kind {
+		GzipDeflate = 0,	// gzip compressor
+		GzipInflate,		// gzip decompressor
+		n_kinds
+	};
+
+private:
+	Slab		slab;		// zalloc()/zfree() memory
+	std::vector<Zlib*> idle[n_kinds]; // Streams ready for reuse
+	size_t		max_idle;	// Per kind
+
+public:	size_t		created = 0;	// Streams constructed
+	size_t		reused = 0;	// Streams handed out again
+
+	static const size_t inbuf_size = 8*1024;
+	static const size_t outbuf_size = 16*1024;
+
+	ZlibPool(size_t max_idle=16);
+	~ZlibPool();
+
+	ZlibPtr get(Kind kind,Zlib::write_cb_t write_cb,int level=Z_BEST_SPEED);
+	void put(Zlib *zlib) noexcept;
+	const Slab& memory() const noexcept { return slab; }
+
+	static ZlibPool& local();
+};
+
 namespace Gzip {
 	std::stringstream *compress(std::stringstream& instr,int wbits=9);
 	std::stringstream *decompress(std::stringstream& instr,int wbits=15);
 	std::stringstream *decompress(const char *data,size_t bytes,int wbits=15);
+
+	bool compressible(const Slice& content_type,long content_length,size_t min_size=1024) noexcept;
 }
 
 #endif // GZIP_HPP
@@ -0,0 +1,54 @@
+//////////////////////////////////////////////////////////////////////
+// hdrids.cpp -- Known http header names as integer IDs
+// Date: Mon Oct 19 11:20:44 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+#include "hdrids.hpp"
+#include "hdrids.inc"
+
+static const Slice hdr_names[H_Count] = {
+	Slice("",0),
+#define X(id,name) Slice(name,sizeof name - 1),
+	HTTP_HEADERS(X)
+#undef X
+};
+
+//////////////////////////////////////////////////////////////////////
+// Map a header name (any case) to its HeaderId, with one hash and
+// at most one comparison:
+//
+// RETURNS:
+//	H_Unknown	Not a standard header
+//	Otherwise	The header's ID
+//////////////////////////////////////////////////////////////////////
+
+HeaderId
+header_id(const char *name,size_t len) noexcept {
+	unsigned id = hdr_table[casehash(name,len,hdr_seed) & (hdr_slots - 1)];
+
+	if ( id && hdr_names[id].iequals(name,len) )
+		return HeaderId(id);
+	return H_Unknown;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the canonical name of a header ID
+//////////////////////////////////////////////////////////////////////
+
+const Slice&
+header_name(HeaderId id) noexcept {
+
+	if ( unsigned(id) >= unsigned(H_Count) )
+		id = H_Unknown;
+	return hdr_names[id];
+}
+
+// End hdrids.cpp
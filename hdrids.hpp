@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////
+// hdrids.hpp -- Known http header names as integer IDs
+// Date: Mon Oct 19 11:02:18 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef HDRIDS_HPP
+#define HDRIDS_HPP
+
+#include <stdint.h>
+
+#include "utility.hpp"
+
+//////////////////////////////////////////////////////////////////////
+// Standard header names. After changing this list, regenerate the
+// perfect hash table (hdrids.inc) with "make hdrids", and commit it.
+//////////////////////////////////////////////////////////////////////
+
+#define HTTP_HEADERS(X) \
+	X(Accept,			"Accept") \
+	X(AcceptCharset,		"Accept-Charset") \
+	X(AcceptEncoding,		"Accept-Encoding") \
+	X(AcceptLanguage,		"Accept-Language") \
+	X(AcceptRanges,			"Accept-Ranges") \
+	X(AccessControlAllowCredentials,"Access-Control-Allow-Credentials") \
+	X(AccessControlAllowHeaders,	"Access-Control-Allow-Headers") \
+	X(AccessControlAllowMethods,	"Access-Control-Allow-Methods") \
+	X(AccessControlAllowOrigin,	"Access-Control-Allow-Origin") \
+	X(AccessControlExposeHeaders,	"Access-Control-Expose-Headers") \
+	X(AccessControlMaxAge,		"Access-Control-Max-Age") \
+	X(AccessControlRequestHeaders,	"Access-Control-Request-Headers") \
+	X(AccessControlRequestMethod,	"Access-Control-Request-Method") \
+	X(Age,				"Age") \
+	X(Allow,			"Allow") \
+	X(Authorization,		"Authorization") \
+	X(CacheControl,			"Cache-Control") \
+	X(Connection,			"Connection") \
+	X(ContentDisposition,		"Content-Disposition") \
+	X(ContentEncoding,		"Content-Encoding") \
+	X(ContentLanguage,		"Content-Language") \
+	X(ContentLength,		"Content-Length") \
+	X(ContentLocation,		"Content-Location") \
+	X(ContentRange,			"Content-Range") \
+	X(ContentSecurityPolicy,	"Content-Security-Policy") \
+	X(ContentType,			"Content-Type") \
+	X(Cookie,			"Cookie") \
+	X(Date,				"Date") \
+	X(DNT,				"DNT") \
+	X(ETag,				"ETag") \
+	X(Expect,			"Expect") \
+	X(Expires,			"Expires") \
+	X(Forwarded,			"Forwarded") \
+	X(From,				"From") \
+	X(Host,				"Host") \
+	X(IfMatch,			"If-Match") \
+	X(IfModifiedSince,		"If-Modified-Since") \
+	X(IfNoneMatch,			"If-None-Match") \
+	X(IfRange,			"If-Range") \
+	X(IfUnmodifiedSince,		"If-Unmodified-Since") \
+	X(KeepAlive,			"Keep-Alive") \
+	X(LastModified,			"Last-Modified") \
+	X(Link,				"Link") \
+	X(Location,			"Location") \
+	X(MaxForwards,			"Max-Forwards") \
+	X(Origin,			"Origin") \
+	X(Pragma,			"Pragma") \
+	X(ProxyAuthenticate,		"Proxy-Authenticate") \
+	X(ProxyAuthorization,		"Proxy-Authorization") \
+	X(ProxyConnection,		"Proxy-Connection") \
+	X(Range,			"Range") \
+	X(Referer,			"Referer") \
+	X(RetryAfter,			"Retry-After") \
+	X(Server,			"Server") \
+	X(SetCookie,			"Set-Cookie") \
+	X(StrictTransportSecurity,	"Strict-Transport-Security") \
+	X(TE,				"TE") \
+	X(Trailer,			"Trailer") \
+	X(TransferEncoding,		"Transfer-Encoding") \
+	X(Upgrade,			"Upgrade") \
+	X(UpgradeInsecureRequests,	"Upgrade-Insecure-Requests") \
+	X(UserAgent,			"User-Agent") \
+	X(Vary,				"Vary") \
+	X(Via,				"Via") \
+	X(Warning,			"Warning") \
+	X(WWWAuthenticate,		"WWW-Authenticate") \
+	X(XForwardedFor,		"X-Forwarded-For") \
+	X(XForwardedHost,		"X-Forwarded-Host") \
+	X(XForwardedProto,		"X-Forwarded-Proto") \
+	X(XRequestId,			"X-Request-Id")
+
+enum HeaderId : uint8_t {
+	H_Unknown = 0,			// Not a standard header
+#define X(id,name) H_##id,
+	HTTP_HEADERS(X)
+#undef X
+	H_Count				// Number of IDs including H_Unknown
+};
+
+HeaderId header_id(const char *name,size_t len) noexcept;
+inline HeaderId header_id(const Slice& name) noexcept { return header_id(name.data,name.size); }
+const Slice& header_name(HeaderId id) noexcept;
+
+#endif // HDRIDS_HPP
+
+// End hdrids.hpp
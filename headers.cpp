@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////////////
+// headers.cpp -- Flat http header container
+// Date: Mon Oct 19 10:24:33 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+#include "headers.hpp"
+
+void
+HeaderMap::clear() noexcept {
+	hdrs = inline_hdrs;		// Arena storage is released by Arena::reset()
+	n_hdrs = 0;
+	n_cap = n_inline;
+	memset(index,0,sizeof index);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Append a header. The slices are not copied, and must remain valid
+// for the life of the request.
+//////////////////////////////////////////////////////////////////////
+
+void
+HeaderMap::add(const Slice& name,const Slice& value) {
+
+	if ( n_hdrs >= n_cap ) {
+		Header *nhdrs = (Header *)arena.alloc(n_cap * 2 * sizeof(Header),alignof(Header));
+
+		memcpy(nhdrs,hdrs,n_hdrs * sizeof(Header));
+		hdrs = nhdrs;
+		n_cap *= 2;
+	}
+
+	Header& hdr = hdrs[n_hdrs++];
+	hdr.name = name;
+	hdr.value = value;
+	hdr.id = header_id(name);
+	if ( hdr.id != H_Unknown && !index[hdr.id] && n_hdrs <= 0xFFFF )
+		index[hdr.id] = uint16_t(n_hdrs);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the value of the first header matching name, else nullptr
+//////////////////////////////////////////////////////////////////////
+
+const Slice *
+HeaderMap::find(const Slice& name) const noexcept {
+	HeaderId id = header_id(name);
+
+	if ( id != H_Unknown )
+		return find(id);
+
+	for ( size_t x=0; x<n_hdrs; ++x ) {
+		const Header& hdr = hdrs[x];
+
+		if ( hdr.name.iequals(name.data,name.size) )
+			return &hdr.value;
+	}
+	return nullptr;
+}
+
+size_t
+HeaderMap::count(const Slice& name) const noexcept {
+	size_t n = 0;
+
+	for ( size_t x=0; x<n_hdrs; ++x )
+		if ( hdrs[x].name.iequals(name.data,name.size) )
+			++n;
+	return n;
+}
+
+// End headers.cpp
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////
+// headers.hpp -- Flat http header container
+// Date: Mon Oct 19 10:21:09 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef HEADERS_HPP
+#define HEADERS_HPP
+
+#include <stddef.h>
+
+#include "arena.hpp"
+#include "hdrids.hpp"
+#include "utility.hpp"
+
+//////////////////////////////////////////////////////////////////////
+// Flat header container, with case insensitive lookup. Names and
+// values are slices, normally referring to request data held in the
+// per-request Arena. Up to n_inline headers are held without any
+// allocation, beyond which storage comes from the Arena.
+//
+// Standard headers (see hdrids.hpp) are indexed by HeaderId as they
+// are added, so that find(HeaderId) is an array lookup.
+//
+// NOTES:
+//	1. clear() must be called when the Arena is reset.
+//////////////////////////////////////////////////////////////////////
+
+class HeaderMap {
+public:	struct Header {
+		Slice	name;			// Header name (as received)
+		Slice	value;			// Value, trimmed of whitespace
+		HeaderId id;			// Known header ID, else H_Unknown
+	};
+
+private:
+	static const size_t n_inline = 32;
+
+	Arena		&arena;			// Overflow storage
+	Header		inline_hdrs[n_inline];	// Inline storage
+	Header		*hdrs;			// Headers (inline_hdrs or Arena)
+	size_t		n_hdrs=0;		// Number of headers held
+	size_t		n_cap=n_inline;		// Capacity of hdrs
+	uint16_t	index[H_Count];		// First header by ID (x+1), else 0
+
+public:	HeaderMap(Arena& arena) : arena(arena), hdrs(inline_hdrs) { memset(index,0,sizeof index); }
+	HeaderMap(const HeaderMap&) = delete;
+	HeaderMap& operator=(const HeaderMap&) = delete;
+
+	void clear() noexcept;
+	void add(const Slice& name,const Slice& value);
+
+	const Slice *find(HeaderId id) const noexcept {
+		return index[id] ? &hdrs[index[id] - 1].value : nullptr;
+	}
+	const Slice *find(const Slice& name) const noexcept;
+	const Slice *find(const char *name) const noexcept	{ return find(Slice(name)); }
+	size_t count(const Slice& name) const noexcept;
+
+	size_t size() const noexcept		{ return n_hdrs; }
+	bool empty() const noexcept		{ return !n_hdrs; }
+	const Header *begin() const noexcept	{ return hdrs; }
+	const Header *end() const noexcept	{ return hdrs + n_hdrs; }
+};
+
+#endif // HEADERS_HPP
+
+// End headers.hpp
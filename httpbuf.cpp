@@ -150,10 +150,11 @@ HttpBuf::read_body(int fd,readcb_t readcb,void *arg,size_t content_length) {
 	int rc;
 
 	assert(size_t(tellp()) >= bpos);
+	req_end = bpos + content_length;	// Anything beyond is a pipelined request
 	if ( content_length <= 0 )
-		return size_t(tellp()) - bpos;	// Content length
+		return 0;			// No body
 
-	while ( size_t(tellp()) < bpos + content_length ) {
+	while ( size_t(tellp()) < req_end ) {
 		rc = readcb(fd,buf,sizeof buf,arg);
 		if ( rc < 0 )
 			return rc;		// Return I/O error
@@ -161,129 +162,158 @@ HttpBuf::read_body(int fd,readcb_t readcb,void *arg,size_t content_length) {
 			return 0;		// EOF!
 		std::stringstream::write(buf,rc);			
 	}
-	return size_t(tellp()) - bpos;		// Actual body size (read)
+	return content_length;			// Actual body size (read)
 }
 
 //////////////////////////////////////////////////////////////////////
-// Read a chunked body, starting with text arg prime.
+// Read a chunked body, decoding into unchunked. The raw chunked body
+// is kept in this buffer, so that parse_xheaders() can later parse
+// the trailer-part.
+//
+// RETURNS:
+//	< 0	Fatal I/O error (-EPROTO for bad chunked framing)
+//	0	EOF before the end of the body
+//	> 0	Size of the decoded body
 //////////////////////////////////////////////////////////////////////
 
 int
 HttpBuf::read_chunked(int fd,readcb_t readcb,void *arg,std::stringstream& unchunked) {
 	size_t bpos = hdr_epos + hdr_elen;
-	char buf[2048], ch;
-	size_t chunk_size;
+	ChunkDecoder decoder;
+	const char *run;
+	size_t n, used, runlen;
+	char buf[2048];
 	int rc;
 
 	assert(size_t(tellp()) >= bpos);
+	seekg(bpos);
 
-	struct IO_Exception : public std::exception {
-		int	rc;
-		IO_Exception(int rc) : rc(rc) {};
-	};
-
-	auto get_char = [&](char& ch) {
-		while ( tellg() >= tellp() ) {
+	while ( decoder.status() == ChunkDecoder::More ) {
+		if ( tellg() >= tellp() ) {
 			rc = readcb(fd,buf,sizeof buf,arg);
 			if ( rc <= 0 )
-				throw IO_Exception(rc);
+				return rc;			// I/O error, or EOF
 			std::stringstream::write(buf,rc);
 		}
-		get(ch);
-	};
 
-	auto copy_unch = [&](size_t n) {
-		size_t sn;
-		while ( n > 0u ) {
-			sn = readsome(buf,n < sizeof buf ? n : sizeof buf);
-			unchunked.write(buf,sn);
-			n -= sn;
+		n = std::stringstream::readsome(buf,sizeof buf);
+		for ( used = 0; used < n && decoder.status() == ChunkDecoder::More; ) {
+			used += decoder.decode(buf + used,n - used,&run,&runlen);
+			if ( runlen > 0 )
+				unchunked.write(run,runlen);	// Payload run
 		}
-	};
+		if ( used < n )
+			seekg(size_t(tellg()) - (n - used));	// Not part of this body
+	}
 
-	auto read_dat = [&](size_t n) {
-		while ( n > 0u ) {
-			rc = readcb(fd,buf,n < sizeof buf ? n : sizeof buf,arg);
-			if ( rc <= 0 )
-				throw IO_Exception(rc);
-			std::stringstream::write(buf,rc);
-			n -= rc;
-		}
-	};
+	if ( decoder.status() == ChunkDecoder::Error )
+		return -EPROTO;
 
-	auto got_eol = [&]() -> bool {
-		if ( ch == '\r' ) {
-			get_char(ch);		// Try to eat LF
-			if ( ch != '\n' )
-				unget();	// Not LF, so give it back
-			return true;
-		}
-		if ( ch == '\n' )		// Got LF instead, treat as CR LF
-			return true;
-		return false;			// ch is not at EOL
-	};
+	hdr_chunked = bpos + decoder.trailer_offset();	// Position of where extended headers go
+	hdr_chunklen = size_t(tellg()) - hdr_chunked;	// Length of extended headers
+	req_end = tellg();				// Pipelined request follows
 
-	auto eat_eol = [&]() -> bool {
-		get_char(ch);
-		return got_eol();
-	};
+	return int(unchunked.tellp());
+}
 
-	try	{
-		for (;;) {
-			//////////////////////////////////////////////
-			// Read in the chunk's size
-			//////////////////////////////////////////////
-			chunk_size = 0;
-			for (;;) {
-				get_char(ch);
-				if ( ch >= '0' && ch <= '9' )
-					chunk_size = chunk_size * 10u + (ch & 0x0F);
-				else if ( (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F') )
-					chunk_size = chunk_size * 10u + (ch & 0x0F) + 9;
-				else if ( got_eol() )
-					break;
-			}
-			if ( chunk_size == 0u )
-				break;			// End of chunks
-			size_t have = size_t(tellp()) - size_t(tellg());
-
-			if ( have > 0u ) {		// Copy pre-read chunk data, if any
-				if ( have > chunk_size )
-					have = chunk_size;
-				copy_unch(have);
-				chunk_size -= have;
-			}
+//////////////////////////////////////////////////////////////////////
+// Prepare to stream the request body with read_body_chunk(), after
+// parse_headers() has positioned the stream at the start of the body.
+// When max_body is non-zero, a chunked body larger than this fails.
+//////////////////////////////////////////////////////////////////////
 
-			if ( chunk_size > 0u ) {	// Else go read more to satisfy
-				read_dat(chunk_size);
-				copy_unch(chunk_size);
-			}
-			eat_eol();
-		} // Reading chunks
+void
+HttpBuf::begin_body(size_t content_length,bool chunked,size_t max_body) noexcept {
+
+	chunkdec.reset();
+	if ( chunked ) {
+		body_mode = B_Chunked;
+		body_left = 0;
+		req_end = 0;			// Known when the last chunk is read
+		chunkdec.limits(max_body ? max_body : uint64_t(1) << 40,max_body);
+	} else	{
+		body_mode = B_Length;
+		body_left = content_length;
+		req_end = hdr_epos + hdr_elen + content_length;
+	}
+}
 
-		//////////////////////////////////////////////////////
-		// Skip over trailer-part
-		//////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////
+// Stream the next part of the body into the caller's buffer. Bytes
+// already buffered are returned first, and then the socket is read
+// directly into buf, never reading past the end of the body. Chunked
+// framing is removed in place.
+//
+// RETURNS:
+//	< 0	Fatal error (-EPIPE for EOF before end of body,
+//		-EPROTO for bad chunked framing)
+//	0	End of body
+//	> 0	Number of body bytes placed into buf
+// NOTES:
+//	1. The body must be fully consumed before calling next(),
+//	   when pipelined requests are to be retained.
+//////////////////////////////////////////////////////////////////////
 
-		hdr_chunked = tellg();			// Position of where extended headers go
+int
+HttpBuf::read_body_chunk(int fd,readcb_t readcb,void *arg,void *buf,size_t bytes) {
+	char *cbuf = (char *)buf;
+	size_t used, out;
+	bool streamf;
+	int rc;
+
+	if ( bytes <= 0 )
+		return 0;
+
+	switch ( body_mode ) {
+	case B_None:
+		return 0;
+
+	case B_Length:
+		if ( body_left <= 0 )
+			return 0;		// End of body
+		if ( bytes > body_left )
+			bytes = body_left;
+		if ( tellg() < tellp() )
+			rc = std::stringstream::readsome(cbuf,bytes);	// Already buffered
+		else	rc = readcb(fd,cbuf,bytes,arg);
+		if ( rc < 0 )
+			return rc;		// I/O error
+		else if ( rc == 0 )
+			return -EPIPE;		// EOF before end of body
+		body_left -= rc;
+		return rc;
+
+	case B_Chunked:
 		for (;;) {
-			get_char(ch);		
-			if ( got_eol() )
-				break;
-			// Skip trailer-part
-			for (;;) {
-				get_char(ch);
-				if ( got_eol() )
-					break;
+			if ( chunkdec.status() == ChunkDecoder::Done )
+				return 0;	// End of body
+
+			streamf = tellg() < tellp();
+			if ( streamf )
+				rc = std::stringstream::readsome(cbuf,bytes);
+			else	rc = readcb(fd,cbuf,bytes,arg);
+			if ( rc < 0 )
+				return rc;
+			else if ( rc == 0 )
+				return -EPIPE;
+
+			used = chunkdec.unchunk(cbuf,size_t(rc),&out);
+			if ( chunkdec.status() == ChunkDecoder::Error )
+				return -EPROTO;
+
+			if ( used < size_t(rc) ) {
+				// Give back what follows the body (pipelined):
+				if ( streamf )
+					seekg(size_t(tellg()) - (size_t(rc) - used));
+				else	std::stringstream::write(cbuf + used,size_t(rc) - used);
 			}
+			if ( chunkdec.status() == ChunkDecoder::Done )
+				req_end = tellg();
+			if ( out > 0 )
+				return int(out);
 		}
-		hdr_chunklen = size_t(tellg()) - hdr_chunked;	// Length of extended headers
-
-	} catch ( IO_Exception& e ) {
-		return e.rc;				// I/O error, or EOF
 	}
-
-	return int(unchunked.tellp());
+	return 0;			// Should never get here
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -295,9 +325,71 @@ HttpBuf::reset() noexcept {
 	state = S0CR1;
 	hdr_elen = 0;
 	hdr_epos = 0;
+	hdr_chunked = 0;
+	hdr_chunklen = 0;
+	req_end = 0;
+	body_mode = B_None;
+	body_left = 0;
+	chunkdec.reset();
 	IOBuf::reset();
 }
 
+//////////////////////////////////////////////////////////////////////
+// Reset, freeing the stream buffer and spill (reset() keeps them):
+//////////////////////////////////////////////////////////////////////
+
+void
+HttpBuf::release() noexcept {
+	reset();
+	std::string().swap(spill);
+	IOBuf::release();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the offset one past the end of the current request. When
+// no body was read, the request ends with the header.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+HttpBuf::request_end() noexcept {
+
+	if ( req_end > 0 )
+		return req_end;
+	if ( hdr_elen > 0 )
+		return hdr_epos + hdr_elen;
+	return tellp();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Reset for the next keep-alive request, retaining any bytes that
+// were read beyond the end of the current request (HTTP/1.1
+// pipelining). The retained bytes become the start of the next
+// request, and are scanned again by have_end().
+//
+// NOTES:
+//	1. The bytes are moved through spill, whose capacity (like the
+//	   stream's own) is kept: no allocation in the steady state.
+//////////////////////////////////////////////////////////////////////
+
+void
+HttpBuf::next() noexcept {
+	size_t rpos = request_end(), ppos = tellp();
+
+	if ( rpos >= ppos ) {
+		reset();		// Nothing pipelined
+		return;
+	}
+
+	size_t n = ppos - rpos;		// Pipelined bytes
+
+	spill.resize(n);
+	clear();
+	seekg(rpos);
+	read(&spill[0],n);
+	reset();
+	std::stringstream::write(spill.data(),n);
+}
+
 //////////////////////////////////////////////////////////////////////
 // Parse received header data into header lines:
 //
@@ -372,6 +464,108 @@ HttpBuf::parse_headers(
 	return strtoul(clen.c_str(),nullptr,10); // Body length
 }
 
+//////////////////////////////////////////////////////////////////////
+// Parse received header data into the per-request arena. The header
+// is copied once into the arena, and all returned slices refer to
+// that copy:
+//
+// RETURNS:
+//	0	No body (or is chunked). Indicates no Content-Length
+//		header was found.
+//	>0	Body length
+//	bad_length Invalid Content-Length: not all digits, too large,
+//		or repeated with a different value
+// NOTES:
+//	1. have_end() must have found the end of the header.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+HttpBuf::parse_headers(Arena& arena,Slice& reqtype,Slice& path,Slice& httpvers,HeaderMap& headers) {
+	size_t hlen = hdr_epos + hdr_elen, clen = 0;
+	char *buf = (char *)arena.alloc(hlen + 1,1);
+	const char *p = buf, *e = buf + hdr_epos, *q;
+	bool clenf = false;
+	Slice line;
+
+	seekg(0);
+	std::stringstream::read(buf,hlen);
+	buf[hlen] = 0;
+
+	auto next_line = [&]() -> bool {
+		const char *eol;
+
+		if ( p >= e )
+			return false;
+		eol = (const char *)memchr(p,'\n',size_t(e - p));
+		q = eol ? eol : e;
+		line = Slice(p,size_t(q - p));
+		if ( line.size > 0 && q[-1] == '\r' )
+			--line.size;
+		p = eol ? eol + 1 : e;
+		return line.size > 0;
+	};
+
+	auto trim = [](const char *b,const char *e) -> Slice {
+		while ( b < e && (*b == ' ' || *b == '\t') )
+			++b;
+		while ( e > b && (e[-1] == ' ' || e[-1] == '\t') )
+			--e;
+		return Slice(b,size_t(e - b));
+	};
+
+	reqtype = path = httpvers = Slice();
+
+	if ( next_line() ) {
+		const char *lp = line.data, *le = line.end();
+
+		auto token = [&]() -> Slice {
+			const char *b;
+
+			while ( lp < le && (*lp == ' ' || *lp == '\t') )
+				++lp;
+			for ( b = lp; lp < le && *lp != ' ' && *lp != '\t'; )
+				++lp;
+			return Slice(b,size_t(lp - b));
+		};
+
+		reqtype = token();
+		path = token();
+		httpvers = token();
+
+		while ( next_line() ) {
+			const char *colon = (const char *)memchr(line.data,':',line.size);
+
+			if ( colon )
+				headers.add(trim(line.data,colon),trim(colon + 1,line.end()));
+			else	headers.add(trim(line.data,line.end()),Slice(line.end(),0));
+		}
+	}
+
+	seekg(hlen);				// Seek to start of body
+
+	// Content-Length must be 1*DIGIT, and agree when repeated:
+	for ( const auto& hdr : headers ) {
+		size_t v = 0;
+
+		if ( hdr.id != H_ContentLength )
+			continue;
+		if ( hdr.value.empty() )
+			return bad_length;
+		for ( const char *d = hdr.value.begin(); d < hdr.value.end(); ++d ) {
+			unsigned digit = unsigned(*d - '0');
+
+			if ( digit > 9 || v > (bad_length - 1 - digit) / 10u )
+				return bad_length;	// Junk, or overflow
+			v = v * 10u + digit;
+		}
+		if ( clenf && v != clen )
+			return bad_length;		// Conflicting lengths
+		clen = v;
+		clenf = true;
+	}
+	return clen;				// Body length (0 when none)
+}
+
 //////////////////////////////////////////////////////////////////////
 // Parse out extended headers, if any after chunked data
 //
@@ -439,10 +633,15 @@ HttpBuf::body() noexcept {
 	std::streamsize n;
 	char buf[2048];
 
+	size_t epos = request_end();	// End of body
+
 	seekg(hdr_epos + hdr_elen);	// Start of body
 
-	while ( tellg() < tellp() ) {
-		n = std::stringstream::readsome(buf,sizeof buf);
+	while ( size_t(tellg()) < epos ) {
+		n = size_t(tellg()) + sizeof buf <= epos ? sizeof buf : epos - size_t(tellg());
+		n = std::stringstream::readsome(buf,n);
+		if ( n <= 0 )
+			break;
 		tstr.write(buf,n);
 	}
 	return std::move(tstr.str());
@@ -11,6 +11,8 @@
 #include <functional>
 
 #include "iobuf.hpp"
+#include "chunked.hpp"
+#include "headers.hpp"
 #include "utility.hpp"
 
 typedef std::unordered_multimap<std::string,std::string,s_casehash,s_casecmp> headermap_t;
@@ -28,13 +30,30 @@ class HttpBuf : public IOBuf {
 	short	hdr_elen = 0;			// End length (2=CRLF, 1=LF)
 	size_t	hdr_chunked = 0;		// Start of chunked headers extension
 	short	hdr_chunklen = 0;		// Length of chunked headers extension
+	size_t	req_end = 0;			// End of request (start of pipelined request), when known
 
-public:	HttpBuf() {};
+	enum {
+		B_None, B_Length, B_Chunked	// Streamed body framing
+	}	body_mode = B_None;
+
+	size_t	body_left = 0;			// Remaining Content-Length bytes
+	ChunkDecoder chunkdec;			// Decoder for chunked body
+	std::string spill;			// Pipelined bytes, while compacting (next())
+
+public:	static const size_t bad_length = ~size_t(0);	// parse_headers(): invalid Content-Length
+
+	HttpBuf() {};
 	void reset() noexcept;
+	void next() noexcept;							// Reset, retaining pipelined bytes
+	void release() noexcept;						// Reset, freeing buffer memory
+	size_t request_end() noexcept;						// Offset one past the current request
 	bool have_end(size_t *pepos,size_t *pelen) noexcept; 				// True if we have read end of header
 	int read_header(int fd,readcb_t readcb,void *arg); 				// Read up to end of header
 	int read_body(int fd,readcb_t readcb,void *arg,size_t content_length);		// Ready full body
 	int read_chunked(int fd,readcb_t readcb,void *arg,std::stringstream& unchunked); // Read chunked body/response
+	void begin_body(size_t content_length,bool chunked,size_t max_body=0) noexcept;	// Prepare to stream body
+	int read_body_chunk(int fd,readcb_t readcb,void *arg,void *buf,size_t bytes);	// Stream next part of body
+	bool have_trailer() noexcept		{ return chunkdec.have_trailer(); }
 	int write(int fd,writecb_t,void *arg);						// Write buffer to fd
 	std::string body() noexcept;		// Extract body
 	size_t parse_headers(
@@ -44,6 +63,13 @@ public:	HttpBuf() {};
 	  headermap_t& headers,			// Out: Parsed headers
 	  size_t maxhdr=2048			// In:  Max size of headers buffer for parsing
 	) noexcept;
+	size_t parse_headers(
+	  Arena& arena,				// In:  Per-request arena
+	  Slice& reqtype,			// Out: GET/POST
+	  Slice& path,				// Out: Path component
+	  Slice& httpvers,			// Out: HTTP/x.x
+	  HeaderMap& headers			// Out: Parsed headers
+	);
 	bool parse_xheaders(headermap_t& headers,size_t maxhdr);
 };
 
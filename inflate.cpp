@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////
+// inflate.cpp -- Streaming decoding of gzip request bodies
+// Date: Mon Oct 19 19:03:40 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <string.h>
+
+#include "inflate.hpp"
+#include "scheduler.hpp"
+
+//////////////////////////////////////////////////////////////////////
+// Start decoding a new body (after HttpBuf::begin_body()):
+//////////////////////////////////////////////////////////////////////
+
+void
+BodyInflater::begin() {
+	zlib = ZlibPool::local().get(ZlibPool::GzipInflate,write_cb);
+	out.clear();
+	outx = 0;
+	err = 0;
+	endf = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Release the stream to the pool, when a body is abandoned (read()
+// does so at the end of the body). The Service coroutine is deleted
+// without unwinding its stack, so this must be called before it is
+// terminated.
+//////////////////////////////////////////////////////////////////////
+
+void
+BodyInflater::end() noexcept {
+	zlib.reset();
+	std::string().swap(out);
+	outx = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Zlib output: enforce the limits before keeping the output
+//////////////////////////////////////////////////////////////////////
+
+void
+BodyInflater::write_cb(void *buf,size_t bytes,void *arg) {
+	BodyInflater& bi = *(BodyInflater *)arg;
+	size_t in = bi.zlib->total_in(), total = bi.zlib->total_out();
+
+	if ( total > bi.max_out || (total > ratio_floor && total / (in ? in : 1) > bi.max_ratio) ) {
+		bi.zlib->abort();		// Decompression bomb (or too large)
+		return;
+	}
+	bi.out.append((const char *)buf,bytes);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Read up to bytes of decompressed body into dst:
+//
+// RETURNS:
+//	< 0	Error: -EMSGSIZE when a limit was exceeded, -EPROTO for
+//		corrupt or truncated gzip data, or an I/O or framing
+//		error from read_body_chunk()
+//	0	End of body
+//	> 0	Bytes returned in dst
+// NOTES:
+//	1. Data following a gzip member must be another member:
+//	   anything else is corrupt data (-EPROTO).
+//////////////////////////////////////////////////////////////////////
+
+int
+BodyInflater::read(Service& svc,int fd,HttpBuf& buf,void *dst,size_t bytes) {
+	char raw[feed_size];
+	int rc, zrc;
+	size_t n;
+
+	if ( err )
+		return err;
+
+	while ( outx >= out.size() ) {
+		out.clear();
+		outx = 0;
+		if ( endf ) {
+			zlib.reset();			// Back to the pool
+			return 0;
+		}
+
+		rc = svc.read_body_chunk(fd,buf,raw,sizeof raw);
+		if ( rc < 0 )
+			return err = rc;		// I/O or framing error
+
+		if ( rc == 0 ) {
+			zrc = zlib->finish(this);	// Truncated unless a member ended
+			endf = true;
+		} else	{
+			zrc = zlib->decompress(raw,size_t(rc),this);
+			if ( zrc == Z_STREAM_END )
+				zrc = Z_OK;		// More input is the next member
+		}
+
+		if ( zrc == Zlib::Aborted )
+			return err = -EMSGSIZE;
+		if ( zrc == Z_MEM_ERROR )
+			return err = -ENOMEM;
+		if ( zrc != Z_OK )
+			return err = -EPROTO;
+	}
+
+	n = out.size() - outx;
+	if ( n > bytes )
+		n = bytes;
+	memcpy(dst,out.data()+outx,n);
+	outx += n;
+	return int(n);
+}
+
+// End inflate.cpp
@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////////////////
+// inflate.hpp -- Streaming decoding of gzip request bodies
+// Date: Mon Oct 19 19:03:40 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// BodyInflater reads a request body sent with Content-Encoding: gzip
+// through Service::read_body_chunk(), and returns it decompressed by
+// a pooled Zlib stream. Compressed input is fed feed_size bytes at a
+// time, so memory stays bounded. Decompression is aborted as soon as
+// the output exceeds max_out bytes, or max_ratio times the input
+// (once past ratio_floor bytes), which defeats decompression bombs.
+// A body of concatenated gzip members (RFC 1952) is decoded whole,
+// the limits applying to all members together.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef INFLATE_HPP
+#define INFLATE_HPP
+
+#include <string>
+
+#include "gzip.hpp"
+
+class Service;
+class HttpBuf;
+
+class BodyInflater {
+	ZlibPtr		zlib;			// Pooled gzip decompressor
+	std::string	out;			// Decompressed, not yet returned
+	size_t		outx = 0;		// Next byte of out to return
+	size_t		max_out;		// Limit on decompressed size
+	size_t		max_ratio;		// Limit on decompressed:compressed
+	int		err = 0;		// Sticky error (-errno)
+	bool		endf = false;		// Body fully read
+
+	static void write_cb(void *buf,size_t bytes,void *arg);
+
+public:	static const size_t feed_size = 1024;		// Compressed bytes per decompress()
+	static const size_t ratio_floor = 64*1024;	// Output allowed before the ratio applies
+
+	BodyInflater(size_t max_out=64*1024*1024,size_t max_ratio=200)
+		: max_out(max_out), max_ratio(max_ratio) {}
+
+	void limits(size_t max_out,size_t max_ratio) noexcept {
+		this->max_out = max_out;
+		this->max_ratio = max_ratio;
+	}
+
+	void begin();
+	int read(Service& svc,int fd,HttpBuf& buf,void *dst,size_t bytes);
+	void end() noexcept;
+
+	size_t in_bytes() const noexcept	{ return zlib ? zlib->total_in() : 0; }
+	size_t out_bytes() const noexcept	{ return zlib ? zlib->total_out() : 0; }
+};
+
+#endif // INFLATE_HPP
+
+// End inflate.hpp
@@ -39,4 +39,37 @@ IOBuf::reset() noexcept {
 	std::stringstream::clear();
 }
 
+//////////////////////////////////////////////////////////////////////
+// Copy the contents into s. Unlike str(), which returns a new string
+// each call, this reuses the capacity of s: no allocation once s has
+// grown to the usual size. The read position is preserved.
+//////////////////////////////////////////////////////////////////////
+
+std::string&
+IOBuf::copy(std::string& s) {
+	std::streampos gpos = tellg(), ppos = tellp();
+
+	if ( ppos <= 0 ) {
+		s.clear();
+		return s;
+	}
+	s.resize(size_t(ppos));
+	seekg(0);
+	read(&s[0],ppos);
+	clear();
+	seekg(gpos < 0 ? std::streampos(0) : gpos);
+	return s;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Reset, and free the buffer (reset() keeps its capacity for reuse):
+//////////////////////////////////////////////////////////////////////
+
+void
+IOBuf::release() noexcept {
+	std::stringstream empty;
+
+	std::stringstream::swap(empty);
+}
+
 // End iobuf.cpp
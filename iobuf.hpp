@@ -13,7 +13,9 @@ class IOBuf : public std::stringstream {
 
 public:	IOBuf() {};
 	void reset() noexcept;
+	void release() noexcept;		// Reset, freeing the buffer's memory
 	std::string sample() noexcept;		// Non-destructive sample of std::stringstream
+	std::string& copy(std::string& s);	// Copy contents into s, reusing its capacity
 };
 
 #endif // IOBUF_HPP
@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////////////////
+// load.cpp -- Scheduler load statistics and compression policy
+// Date: Mon Oct 19 17:48:12 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include "load.hpp"
+
+//////////////////////////////////////////////////////////////////////
+// Record one event loop wakeup:
+//
+// ARGUMENTS:
+//	busy_ns		Time spent running ready services
+//	wait_ns		Time spent in epoll_wait(2)
+//	ready		Events returned by epoll_wait(2)
+//	resumed		Services resumed (events and expired timers)
+//	cpu_ns		Thread CPU time used while busy
+//////////////////////////////////////////////////////////////////////
+
+void
+LoadStats::sample(long busy_ns,long wait_ns,unsigned ready,unsigned resumed,long cpu_ns) noexcept {
+	double total = double(busy_ns) + double(wait_ns);
+
+	if ( total > 0.0 )
+		util += alpha * (double(busy_ns) / total - util);
+	lag += alpha * (double(busy_ns) / 1e6 - lag);
+	depth += alpha * (double(ready) - depth);
+	if ( resumed > 0 )
+		cpu += alpha * (double(cpu_ns) / 1e3 / double(resumed) - cpu);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Choose a compression level for the current load:
+//
+// RETURNS:
+//	0	Do not compress (identity coding)
+//	> 0	zlib level to use
+//////////////////////////////////////////////////////////////////////
+
+int
+CompressPolicy::level(const LoadStats& load) const noexcept {
+	double u = load.utilization();
+
+	if ( u >= max_util || load.lag_ms() >= max_lag_ms || load.ready_depth() >= max_depth )
+		return 0;			// Saturated: spend no CPU on compression
+	if ( u >= busy_util || load.cpu_us() >= max_cpu_us )
+		return busy_level;
+	if ( u <= idle_util )
+		return idle_level;
+
+	// Scale between idle and busy levels:
+	double f = (u - idle_util) / (busy_util - idle_util);
+
+	return idle_level - int(f * double(idle_level - busy_level) + 0.5);
+}
+
+// End load.cpp
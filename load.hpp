@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////
+// load.hpp -- Scheduler load statistics and compression policy
+// Date: Mon Oct 19 17:48:12 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// LoadStats keeps moving averages of a Scheduler's event loop, one
+// sample per epoll_wait(2) wakeup: the fraction of time busy, the
+// time spent running a batch of ready services (how late the last of
+// them ran: loop lag), the number of ready events per wakeup (ready
+// queue depth) and the thread CPU time per resumed service.
+//
+// CompressPolicy maps these to a zlib compression level: a better
+// ratio when idle, the fastest level when busy, and 0 (identity
+// coding) when the loop is saturated.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef LOAD_HPP
+#define LOAD_HPP
+
+class LoadStats {
+	double		util = 0.0;		// Busy fraction (0..1)
+	double		lag = 0.0;		// Batch run time (ms)
+	double		depth = 0.0;		// Ready events per wakeup
+	double		cpu = 0.0;		// CPU per resumed service (us)
+
+	static constexpr double alpha = 1.0 / 16.0;	// Moving average weight
+
+public:	void sample(long busy_ns,long wait_ns,unsigned ready,unsigned resumed,long cpu_ns) noexcept;
+
+	double utilization() const noexcept	{ return util; }
+	double lag_ms() const noexcept		{ return lag; }
+	double ready_depth() const noexcept	{ return depth; }
+	double cpu_us() const noexcept		{ return cpu; }
+};
+
+struct CompressPolicy {
+	int		idle_level = 6;		// Level when idle
+	int		busy_level = 1;		// Level when busy
+	double		idle_util = 0.30;	// Busy fraction below which we are idle
+	double		busy_util = 0.70;	// Above: busy_level
+	double		max_util = 0.90;	// Above: identity
+	double		max_lag_ms = 20.0;	// Loop lag above: identity
+	double		max_depth = 512.0;	// Ready depth above: identity
+	double		max_cpu_us = 2000.0;	// CPU per request above: busy_level
+
+	int level(const LoadStats& load) const noexcept;
+};
+
+#endif // LOAD_HPP
+
+// End load.hpp
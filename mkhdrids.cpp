@@ -0,0 +1,57 @@
+//////////////////////////////////////////////////////////////////////
+// mkhdrids.cpp -- Generate the perfect hash table for hdrids.cpp
+// Date: Mon Oct 19 11:09:50 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hdrids.hpp"
+
+static const char *names[] = {
+	nullptr,
+#define X(id,name) name,
+	HTTP_HEADERS(X)
+#undef X
+};
+
+int
+main(int argc,char **argv) {
+	static const unsigned table_size = 256;
+	unsigned char table[table_size];
+	unsigned slot;
+	bool okf = false;
+	uint64_t seed;
+
+	//////////////////////////////////////////////////////////////
+	// Search for a seed giving each name a distinct slot:
+	//////////////////////////////////////////////////////////////
+
+	for ( seed = 1; !okf && seed < 10000000; ++seed ) {
+		memset(table,0,sizeof table);
+		okf = true;
+		for ( unsigned x=1; okf && x < H_Count; ++x ) {
+			slot = casehash(names[x],strlen(names[x]),seed) & (table_size - 1);
+			if ( table[slot] )
+				okf = false;
+			else	table[slot] = x;
+		}
+	}
+
+	if ( !okf ) {
+		fprintf(stderr,"No perfect hash seed found.\n");
+		return 1;
+	}
+
+	printf("// Generated by mkhdrids -- do not edit\n\n");
+	printf("static const uint64_t hdr_seed = %lluu;\n",(unsigned long long)(seed - 1));
+	printf("static const unsigned hdr_slots = %uu;\n\n",table_size);
+	printf("static const uint8_t hdr_table[%u] = {",table_size);
+	for ( unsigned x=0; x < table_size; ++x )
+		printf("%s%3u,",x % 16 ? " " : "\n\t",table[x]);
+	printf("\n};\n");
+	return 0;
+}
+
+// End mkhdrids.cpp
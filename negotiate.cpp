@@ -0,0 +1,196 @@
+//////////////////////////////////////////////////////////////////////
+// negotiate.cpp -- Accept-Encoding content negotiation
+// Date: Mon Oct 19 20:37:55 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "negotiate.hpp"
+#include "zstd.hpp"
+
+const char *
+encoding_name(Encoding enc) noexcept {
+	static const char *names[E_Count] = { "identity", "gzip", "zstd" };
+
+	return unsigned(enc) < E_Count ? names[enc] : "identity";
+}
+
+//////////////////////////////////////////////////////////////////////
+// The most preferred acceptable coding among those available (a mask
+// of encoding_bit()). identity is the fallback, even when the client
+// excluded it (we do not send 406).
+//////////////////////////////////////////////////////////////////////
+
+Encoding
+Accept::choose(unsigned available) const noexcept {
+	unsigned ok = mask & available;
+
+	for ( unsigned x = 0; x < E_Count; ++x )
+		if ( ok & (1u << order[x]) )
+			return Encoding(order[x]);
+	return E_Identity;
+}
+
+unsigned
+Negotiator::supported() noexcept {
+	return encoding_bit(E_Identity) | encoding_bit(E_Gzip) | (Zstd::available ? encoding_bit(E_Zstd) : 0);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Parse a qvalue: "0" [ "." 0*3DIGIT ] or "1" [ "." 0*3("0") ]
+//
+// RETURNS:
+//	0..1000	q times 1000
+//	-1	Malformed
+//////////////////////////////////////////////////////////////////////
+
+static int
+qvalue(const char *p,const char *e) noexcept {
+	int q, scale = 100;
+
+	if ( p >= e || (*p != '0' && *p != '1') )
+		return -1;
+	q = (*p++ - '0') * 1000;
+	if ( p < e && *p == '.' ) {
+		for ( ++p; p < e && *p >= '0' && *p <= '9'; ++p ) {
+			q += (*p - '0') * scale;
+			scale /= 10;		// Digits past the third are ignored
+		}
+	}
+	if ( p != e || q > 1000 )
+		return -1;
+	return q;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Parse an Accept-Encoding value:
+//
+//	codings with q=0 are not acceptable, "*" applies to codings not
+//	listed, and identity is acceptable unless excluded, though least
+//	preferred when not listed. Unknown codings are ignored, as are
+//	elements with a malformed q-value.
+//////////////////////////////////////////////////////////////////////
+
+Accept
+Negotiator::parse(const Slice& header) noexcept {
+	static const uint8_t ours[E_Count] = { E_Zstd, E_Gzip, E_Identity };
+	const char *p = header.data, *e = header.end();
+	int q[E_Count], star = -1;
+	Accept acc;
+
+	for ( auto& v : q )
+		v = -1;				// Not listed
+
+	auto ows = [&]() {
+		while ( p < e && (*p == ' ' || *p == '\t') )
+			++p;
+	};
+	auto token = [&](const char *stops) -> Slice {
+		const char *s = p;
+
+		while ( p < e && !strchr(stops,*p) )
+			++p;
+		return Slice(s,size_t(p - s));
+	};
+
+	while ( p < e ) {
+		ows();
+		Slice coding = token(",; \t");
+		int qv = 1000;
+
+		ows();
+		while ( p < e && *p == ';' ) {	// Parameters
+			++p;
+			ows();
+			Slice name = token("=,; \t");
+			ows();
+			Slice value;
+
+			if ( p < e && *p == '=' ) {
+				++p;
+				ows();
+				value = token(",; \t");
+				ows();
+			}
+			if ( name.iequals("q") )
+				qv = qvalue(value.data,value.end());
+		}
+		while ( p < e && *p != ',' )
+			++p;			// Junk
+		if ( p < e )
+			++p;			// ','
+
+		if ( coding.empty() || qv < 0 )
+			continue;
+
+		int x = -1;
+
+		if ( coding.iequals("gzip") || coding.iequals("x-gzip") )
+			x = E_Gzip;
+		else if ( coding.iequals("zstd") )
+			x = E_Zstd;
+		else if ( coding.iequals("identity") )
+			x = E_Identity;
+		else if ( coding.equals("*",1) )
+			star = std::max(star,qv);
+
+		if ( x >= 0 )
+			q[x] = std::max(q[x],qv);
+	}
+
+	for ( int x = 0; x < E_Count; ++x ) {
+		if ( q[x] < 0 )
+			q[x] = star >= 0 ? star : x == E_Identity ? 1 : 0;
+	}
+
+	// Order by q-value, ties by our preference:
+	acc.mask = 0;
+	for ( unsigned x = 0; x < E_Count; ++x ) {
+		unsigned y = x;
+
+		acc.order[x] = ours[x];
+		while ( y > 0 && q[acc.order[y]] > q[acc.order[y-1]] ) {
+			std::swap(acc.order[y],acc.order[y-1]);
+			--y;
+		}
+		if ( q[x] > 0 )
+			acc.mask |= uint8_t(1u << x);
+	}
+	return acc;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Negotiate from the request's Accept-Encoding header (nullptr when
+// absent: identity only), using the memoized result when the same
+// header string was seen before.
+//////////////////////////////////////////////////////////////////////
+
+Accept
+Negotiator::accept_encoding(const Slice *header) noexcept {
+	static const Accept none = { uint8_t(1u << E_Identity), { E_Identity, E_Zstd, E_Gzip } };
+
+	if ( !header )
+		return none;
+
+	if ( header->size == 0 || header->size > max_key ) {
+		++misses;
+		return parse(*header);
+	}
+
+	uint64_t hash = casehash(header->data,header->size);
+	Slot& slot = slots[hash & (n_slots - 1)];
+
+	if ( slot.len == header->size && slot.hash == hash && !memcmp(slot.key,header->data,header->size) ) {
+		++hits;
+		return slot.accept;
+	}
+
+	++misses;
+	slot.accept = parse(*header);
+	slot.hash = hash;
+	slot.len = uint16_t(header->size);
+	memcpy(slot.key,header->data,header->size);
+	return slot.accept;
+}
+
+// End negotiate.cpp
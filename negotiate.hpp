@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////
+// negotiate.hpp -- Accept-Encoding content negotiation
+// Date: Mon Oct 19 20:37:55 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// Negotiator parses Accept-Encoding (RFC 9110 12.5.3) into Accept: a
+// bit mask of the acceptable codings, and the codings in order of
+// preference (q-value, then ours: zstd, gzip, identity). Results are
+// memoized per distinct raw header string in a small direct mapped
+// table, since a handful of browser strings make up nearly all
+// requests: negotiation is then a hash probe and a compare.
+//
+// A Negotiator is not thread safe: each Scheduler owns one.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef NEGOTIATE_HPP
+#define NEGOTIATE_HPP
+
+#include <stdint.h>
+
+#include "utility.hpp"
+
+enum Encoding {
+	E_Identity = 0,
+	E_Gzip,
+	E_Zstd,
+	E_Count
+};
+
+inline unsigned
+encoding_bit(Encoding enc) noexcept {
+	return 1u << enc;
+}
+
+const char *encoding_name(Encoding enc) noexcept;
+
+struct Accept {
+	uint8_t		mask;			// encoding_bit() of acceptable codings
+	uint8_t		order[E_Count];		// Codings, most preferred first
+
+	bool accepts(Encoding enc) const noexcept { return mask & encoding_bit(enc); }
+	Encoding choose(unsigned available) const noexcept;
+};
+
+class Negotiator {
+public:	static const size_t n_slots = 64;	// Memoized header strings (power of 2)
+	static const size_t max_key = 160;	// Longer headers are parsed each time
+
+private:
+	struct Slot {
+		uint64_t	hash = 0;		// casehash() of key
+		uint16_t	len = 0;		// Key length (0 when unused)
+		char		key[max_key];		// Raw header value
+		Accept		accept;			// Parsed result
+	};
+
+	Slot		slots[n_slots];
+
+public:	size_t		hits = 0;
+	size_t		misses = 0;
+
+	Accept accept_encoding(const Slice *header) noexcept;
+
+	static Accept parse(const Slice& header) noexcept;
+	static unsigned supported() noexcept;	// Codings this build can send
+};
+
+#endif // NEGOTIATE_HPP
+
+// End negotiate.hpp
@@ -120,6 +120,28 @@ parse_fields(std::vector<M>& vector,const char *source) {
 	}
 }
 
+//////////////////////////////////////////////////////////////////////
+// Parse a comma separated header list into slices of its elements,
+// dropping any ';' parameters ("gzip;q=0.8, br" yields gzip and br).
+//////////////////////////////////////////////////////////////////////
+
+template<class C>		// Container of Slice
+void
+parse_list(C& container,const Slice& source) {
+	const char *p = source.begin(), *e = source.end(), *b;
+
+	while ( p < e ) {
+		while ( p < e && (*p == ' ' || *p == '\t' || *p == ',') )
+			++p;
+		for ( b = p; p < e && *p != ',' && *p != ';' && *p != ' ' && *p != '\t'; )
+			++p;
+		if ( p > b )
+			container.push_back(Slice(b,size_t(p - b)));
+		while ( p < e && *p != ',' )
+			++p;			// Skip parameters
+	}
+}
+
 #endif // PARSE_HPP
 
 // End parse.hpp
@@ -0,0 +1,180 @@
+//////////////////////////////////////////////////////////////////////
+// query.cpp -- Request target, query string and percent-decoding
+// Date: Mon Oct 19 13:08:40 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "query.hpp"
+
+static inline int
+hexval(unsigned char ch) noexcept {
+
+	if ( unsigned(ch - '0') < 10u )
+		return ch - '0';
+	ch |= 0x20;
+	if ( unsigned(ch - 'a') < 6u )
+		return ch - 'a' + 10;
+	return -1;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Split a request target into path and query (without the '?').
+// Any fragment is dropped from the query.
+//////////////////////////////////////////////////////////////////////
+
+void
+Query::split(const Slice& target,Slice& path,Slice& query) noexcept {
+	const char *q = (const char *)memchr(target.data,'?',target.size), *f;
+
+	if ( !q ) {
+		path = target;
+		query = Slice(target.end(),0);
+		return;
+	}
+	path = Slice(target.data,size_t(q - target.data));
+	++q;
+	f = (const char *)memchr(q,'#',size_t(target.end() - q));
+	query = Slice(q,size_t((f ? f : target.end()) - q));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return a pointer to the first '%' (or '+' when plusf) in p..e,
+// else e. Runs without escapes are skipped 16 bytes at a time with
+// SSE2.
+//////////////////////////////////////////////////////////////////////
+
+const char *
+Query::find_escape(const char *p,const char *e,bool plusf) noexcept {
+
+#ifdef __SSE2__
+	const __m128i pct = _mm_set1_epi8('%');
+	const __m128i plus = _mm_set1_epi8(plusf ? '+' : '%');
+
+	for ( ; e - p >= 16; p += 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v,pct),_mm_cmpeq_epi8(v,plus)));
+
+		if ( mask )
+			return p + __builtin_ctz(mask);
+	}
+#endif
+	for ( ; p < e; ++p )
+		if ( *p == '%' || (plusf && *p == '+') )
+			return p;
+	return e;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Percent-decode buf[0..len-1] in place. When plusf, '+' decodes as
+// a space (query strings). Malformed escapes are left as is.
+//
+// RETURNS:
+//	The decoded length
+//////////////////////////////////////////////////////////////////////
+
+size_t
+Query::decode(char *buf,size_t len,bool plusf) noexcept {
+	const char *p = buf, *e = buf + len, *q;
+	char *out = buf;
+	int hi, lo;
+
+	while ( p < e ) {
+		q = find_escape(p,e,plusf);
+		if ( q > p ) {
+			if ( out != p )
+				memmove(out,p,size_t(q - p));
+			out += q - p;
+			p = q;
+		}
+		if ( p >= e )
+			break;
+
+		if ( *p == '+' ) {
+			*out++ = ' ';
+			++p;
+		} else if ( e - p >= 3 && (hi = hexval(p[1])) >= 0 && (lo = hexval(p[2])) >= 0 ) {
+			*out++ = char(hi << 4 | lo);
+			p += 3;
+		} else	*out++ = *p++;		// Malformed: keep '%'
+	}
+	return size_t(out - buf);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Percent-decode a slice. When nothing needs decoding the slice is
+// returned as is (no copy), else it is decoded into the arena.
+//////////////////////////////////////////////////////////////////////
+
+Slice
+Query::decode(Arena& arena,const Slice& encoded,bool plusf) {
+	const char *q = find_escape(encoded.begin(),encoded.end(),plusf);
+
+	if ( q >= encoded.end() )
+		return encoded;			// Zero copy
+
+	char *buf = arena.strdup(encoded.data,encoded.size);
+	size_t len = size_t(q - encoded.data);
+
+	len += decode(buf + len,encoded.size - len,plusf);
+	buf[len] = 0;
+	return Slice(buf,len);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Find the (raw) value of the first parameter named key
+//////////////////////////////////////////////////////////////////////
+
+bool
+Query::find(const Slice& query,const char *key,Slice& value) noexcept {
+	QueryIter it(query);
+	size_t len = strlen(key);
+	Slice k;
+
+	while ( it.next(k,value) )
+		if ( k.equals(key,len) )
+			return true;
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the next key=value pair. A pair without '=' yields an empty
+// value. Empty pairs ("a=1&&b=2") are skipped.
+//////////////////////////////////////////////////////////////////////
+
+bool
+QueryIter::next(Slice& key,Slice& value) noexcept {
+	const char *amp, *eq;
+
+	while ( p < e ) {
+		amp = (const char *)memchr(p,'&',size_t(e - p));
+		if ( !amp )
+			amp = e;
+		if ( amp > p ) {
+			eq = (const char *)memchr(p,'=',size_t(amp - p));
+			if ( eq ) {
+				key = Slice(p,size_t(eq - p));
+				value = Slice(eq + 1,size_t(amp - eq - 1));
+			} else	{
+				key = Slice(p,size_t(amp - p));
+				value = Slice(amp,0);
+			}
+			p = amp < e ? amp + 1 : e;
+			return true;
+		}
+		p = amp + 1;
+	}
+	return false;
+}
+
+// End query.cpp
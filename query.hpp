@@ -0,0 +1,43 @@
+//////////////////////////////////////////////////////////////////////
+// query.hpp -- Request target, query string and percent-decoding
+// Date: Mon Oct 19 13:05:12 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef QUERY_HPP
+#define QUERY_HPP
+
+#include <stddef.h>
+
+#include "arena.hpp"
+#include "utility.hpp"
+
+//////////////////////////////////////////////////////////////////////
+// Iterate key=value pairs of a query string, as raw (still encoded)
+// slices of the query:
+//
+//	QueryIter it(query);
+//	Slice key, value;
+//
+//	while ( it.next(key,value) )
+//		...
+//////////////////////////////////////////////////////////////////////
+
+class QueryIter {
+	const char	*p;			// Next pair
+	const char	*e;			// End of query
+
+public:	QueryIter(const Slice& query) : p(query.begin()), e(query.end()) {}
+	bool next(Slice& key,Slice& value) noexcept;
+};
+
+namespace Query {
+	void split(const Slice& target,Slice& path,Slice& query) noexcept;
+	const char *find_escape(const char *p,const char *e,bool plusf) noexcept;
+	size_t decode(char *buf,size_t len,bool plusf=true) noexcept;
+	Slice decode(Arena& arena,const Slice& encoded,bool plusf=true);
+	bool find(const Slice& query,const char *key,Slice& value) noexcept;
+}
+
+#endif // QUERY_HPP
+
+// End query.hpp
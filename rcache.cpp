@@ -0,0 +1,197 @@
+//////////////////////////////////////////////////////////////////////
+// rcache.cpp -- In-memory response cache
+// Date: Mon Oct 19 16:21:05 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include "rcache.hpp"
+#include "response.hpp"
+#include "gzip.hpp"
+#include "zstd.hpp"
+
+void
+ResponseCache::limits(size_t max_bytes,unsigned ttl) noexcept {
+	this->max_bytes = max_bytes;
+	this->ttl = ttl;
+	while ( cur_bytes > max_bytes && !lru.empty() )
+		evict(std::prev(lru.end()));
+}
+
+size_t
+ResponseCache::make_key(char *buf,const Slice& method,const Slice& path) noexcept {
+
+	if ( method.size + 1 + path.size > max_key )
+		return 0;			// Not cacheable
+	memcpy(buf,method.data,method.size);
+	buf[method.size] = ' ';
+	memcpy(buf+method.size+1,path.data,path.size);
+	return method.size + 1 + path.size;
+}
+
+void
+ResponseCache::evict(lru_t::iterator it) {
+	Entry& entry = **it;
+
+	index.erase(Slice(entry.key.data(),entry.key.size()));
+	cur_bytes -= entry.bytes;
+	lru.erase(it);				// Freed when no longer being sent
+}
+
+void
+ResponseCache::clear() {
+	index.clear();
+	lru.clear();
+	cur_bytes = 0;
+}
+
+ResponseCache::EntryPtr
+ResponseCache::lookup(const Slice& method,const Slice& path,time_t now) {
+	char buf[max_key];
+	size_t n = make_key(buf,method,path);
+
+	if ( !n ) {
+		++misses;
+		return EntryPtr();
+	}
+
+	auto it = index.find(Slice(buf,n));
+
+	if ( it == index.end() ) {
+		++misses;
+		return EntryPtr();
+	}
+	if ( (*it->second)->expires <= now ) {
+		evict(it->second);		// Stale
+		++misses;
+		return EntryPtr();
+	}
+	lru.splice(lru.begin(),lru,it->second);
+	++hits;
+	return *lru.begin();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Build and cache a response. The gzip variant is compressed once at
+// zlib gzip_level (0 for none, Z_BEST_SPEED by default, as pooled
+// streams are), and the zstd variant at the zstd level of similar
+// cost. Each is kept only when it is smaller than the identity body.
+// The entry is returned even when it is too large to be cached, so
+// that the caller can send it.
+//////////////////////////////////////////////////////////////////////
+
+ResponseCache::EntryPtr
+ResponseCache::insert(const Slice& method,const Slice& path,int status,const Slice& content_type,
+  const Slice& body,time_t now,unsigned ttl,int gzip_level) {
+	std::shared_ptr<Entry> entry(new Entry);
+	char buf[max_key];
+	size_t n = make_key(buf,method,path);
+
+	entry->key.assign(buf,n);
+	entry->expires = now + (ttl ? ttl : this->ttl);
+
+	auto make_head = [&](Variant& v,const Slice& coding) {
+		Slice line = Response::status_line(status);
+		char num[24];
+
+		v.head.reserve(line.size + content_type.size + 96);
+		if ( line.empty() )
+			line = Response::status_line(500);
+		v.head.append(line.data,line.size);
+		v.head.append("Content-Type: ").append(content_type.data,content_type.size).append("\r\n");
+		if ( !coding.empty() )
+			v.head.append("Content-Encoding: ").append(coding.data,coding.size).append("\r\n");
+		v.head.append("Vary: Accept-Encoding\r\nContent-Length: ");
+		v.head.append(num,fmt_uint(num,v.body.size())).append("\r\n");
+	};
+
+	Variant& ident = entry->var[E_Identity];
+
+	ident.body.assign(body.data,body.size);
+	make_head(ident,Slice());
+
+	auto callback = [](void *buf,size_t bytes,void *arg) -> void {
+		((std::string *)arg)->append((const char *)buf,bytes);
+	};
+
+	if ( body.size >= min_gzip && gzip_level > 0 ) {
+		Variant& gz = entry->var[E_Gzip];
+		ZlibPtr zlib = ZlibPool::local().get(ZlibPool::GzipDeflate,callback,gzip_level);
+
+		if ( zlib->compress((void *)body.data,body.size,&gz.body) == Z_OK
+		  && zlib->finish(&gz.body) == Z_OK && gz.body.size() < body.size ) {
+			make_head(gz,"gzip");
+		} else	{
+			std::string().swap(gz.body);	// Failed, or not worth it
+		}
+	}
+
+	if ( body.size >= min_gzip && gzip_level > 0 && Zstd::available ) {
+		Variant& zs = entry->var[E_Zstd];
+		ZstdPtr zstd = ZstdPool::local().get(Zstd::Compress,callback,Zstd::level_for(gzip_level));
+
+		if ( zstd->compress((void *)body.data,body.size,&zs.body) == Z_OK
+		  && zstd->finish(&zs.body) == Z_OK && zs.body.size() < body.size ) {
+			make_head(zs,"zstd");
+		} else	{
+			std::string().swap(zs.body);
+		}
+	}
+
+	entry->bytes = sizeof(Entry) + entry->key.size();
+	for ( auto& v : entry->var )
+		entry->bytes += v.head.size() + v.body.size();
+
+	if ( !n || entry->bytes > max_bytes / 8 )
+		return entry;			// Send, but do not cache
+
+	erase(method,path);
+	while ( cur_bytes + entry->bytes > max_bytes && !lru.empty() )
+		evict(std::prev(lru.end()));
+
+	lru.push_front(entry);
+	index[Slice(entry->key.data(),entry->key.size())] = lru.begin();
+	cur_bytes += entry->bytes;
+	return entry;
+}
+
+void
+ResponseCache::erase(const Slice& method,const Slice& path) {
+	char buf[max_key];
+	size_t n = make_key(buf,method,path);
+
+	if ( n ) {
+		auto it = index.find(Slice(buf,n));
+
+		if ( it != index.end() )
+			evict(it->second);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Fill iov[0..max_iov-1] with the response, in the most preferred of
+// the entry's codings that the client accepts:
+//
+// RETURNS:
+//	The number of iovec entries used.
+//////////////////////////////////////////////////////////////////////
+
+int
+ResponseCache::gather(const Entry& entry,const Accept& accept,const DateCache& date,bool keep_alive,struct iovec *iov) noexcept {
+	static const char keep[] = "Connection: Keep-Alive\r\n\r\n";
+	static const char close[] = "Connection: Close\r\n\r\n";
+	const Variant& v = entry.variant(accept.choose(entry.codings()));
+	Slice dline = date.line();
+
+	iov[0].iov_base = (void *)v.head.data();
+	iov[0].iov_len = v.head.size();
+	iov[1].iov_base = (void *)dline.data;
+	iov[1].iov_len = dline.size;
+	iov[2].iov_base = (void *)(keep_alive ? keep : close);
+	iov[2].iov_len = keep_alive ? sizeof keep - 1 : sizeof close - 1;
+	iov[3].iov_base = (void *)v.body.data();
+	iov[3].iov_len = v.body.size();
+	return 4;
+}
+
+// End rcache.cpp
@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////
+// rcache.hpp -- In-memory response cache
+// Date: Mon Oct 19 16:21:05 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// ResponseCache holds complete responses keyed by method and path.
+// Each entry keeps a ready-made header block and body per content
+// coding (identity, gzip and zstd, compressed once at insert), so that a
+// hit is sent with one gather write, without running the handler.
+// The variant sent is the client's most preferred coding among those
+// stored (see Negotiator).
+//
+// Entries expire after their TTL, and the least recently used are
+// evicted to keep the cache within max_bytes. A cache is not thread
+// safe: each Scheduler owns one shard, so lookups need no locks.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef RCACHE_HPP
+#define RCACHE_HPP
+
+#include <time.h>
+#include <sys/uio.h>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "zlib.h"
+#include "utility.hpp"
+#include "negotiate.hpp"
+
+class DateCache;
+
+class ResponseCache {
+public:	struct Variant {
+		std::string	head;		// Status line and fixed headers (unterminated)
+		std::string	body;		// Body in this coding
+	};
+
+	struct Entry {
+		std::string	key;		// "METHOD path"
+		time_t		expires;	// Time of expiry
+		size_t		bytes;		// Memory charged to the cache
+		Variant		var[E_Count];	// Empty head when not stored
+
+		const Variant& variant(Encoding enc) const noexcept {
+			return var[enc].head.empty() ? var[E_Identity] : var[enc];
+		}
+		unsigned codings() const noexcept {	// encoding_bit() of stored variants
+			unsigned mask = 0;
+
+			for ( unsigned x = 0; x < E_Count; ++x )
+				if ( !var[x].head.empty() )
+					mask |= 1u << x;
+			return mask;
+		}
+	};
+
+	typedef std::shared_ptr<const Entry> EntryPtr;
+
+	static const int max_iov = 4;		// gather() fragments
+	static const size_t max_key = 1024;	// Longer keys are not cached
+	static const size_t min_gzip = 256;	// Smaller bodies are not compressed (any coding)
+
+private:
+	struct s_slicehash {
+		size_t operator()(const Slice& s) const noexcept { return size_t(casehash(s.data,s.size)); }
+	};
+	struct s_sliceeq {
+		bool operator()(const Slice& a,const Slice& b) const noexcept { return a.equals(b.data,b.size); }
+	};
+	typedef std::list<std::shared_ptr<Entry>> lru_t;
+
+	size_t		max_bytes;		// Memory bound
+	unsigned	ttl;			// Default time to live (seconds)
+	size_t		cur_bytes = 0;		// Memory in use
+	lru_t		lru;			// Most recently used first
+	std::unordered_map<Slice,lru_t::iterator,s_slicehash,s_sliceeq> index; // Keys reference Entry::key
+
+public:	size_t		hits = 0;
+	size_t		misses = 0;
+
+private:
+	static size_t make_key(char *buf,const Slice& method,const Slice& path) noexcept;
+	void evict(lru_t::iterator it);
+
+public:	ResponseCache(size_t max_bytes=64*1024*1024,unsigned ttl=60) : max_bytes(max_bytes), ttl(ttl) {}
+
+	void limits(size_t max_bytes,unsigned ttl) noexcept;
+	size_t bytes() const noexcept		{ return cur_bytes; }
+	size_t size() const noexcept		{ return index.size(); }
+
+	EntryPtr lookup(const Slice& method,const Slice& path,time_t now);
+	EntryPtr insert(const Slice& method,const Slice& path,int status,const Slice& content_type,
+		const Slice& body,time_t now,unsigned ttl=0,int gzip_level=Z_BEST_SPEED);
+	void erase(const Slice& method,const Slice& path);
+	void clear();
+
+	static int gather(const Entry& entry,const Accept& accept,const DateCache& date,bool keep_alive,struct iovec *iov) noexcept;
+};
+
+#endif // RCACHE_HPP
+
+// End rcache.hpp
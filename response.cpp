@@ -0,0 +1,284 @@
+//////////////////////////////////////////////////////////////////////
+// response.cpp -- Preformatted HTTP response builder
+// Date: Mon Oct 19 14:10:27 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <time.h>
+
+#include "response.hpp"
+
+static const char days[] = "SunMonTueWedThuFriSat";
+static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+//////////////////////////////////////////////////////////////////////
+// Format t as an RFC 7231 IMF-fixdate, independent of the locale:
+// "Sun, 06 Nov 1994 08:49:37 GMT"
+//////////////////////////////////////////////////////////////////////
+
+size_t
+fmt_http_date(char *buf,time_t t) noexcept {
+	struct tm tm;
+	char *p = buf;
+
+	gmtime_r(&t,&tm);
+
+	auto two = [&p](int v) {
+		*p++ = char('0' + v / 10);
+		*p++ = char('0' + v % 10);
+	};
+
+	memcpy(p,days+tm.tm_wday*3,3);
+	p += 3;
+	*p++ = ',';
+	*p++ = ' ';
+	two(tm.tm_mday);
+	*p++ = ' ';
+	memcpy(p,months+tm.tm_mon*3,3);
+	p += 3;
+	*p++ = ' ';
+	two((tm.tm_year + 1900) / 100);
+	two((tm.tm_year + 1900) % 100);
+	*p++ = ' ';
+	two(tm.tm_hour);
+	*p++ = ':';
+	two(tm.tm_min);
+	*p++ = ':';
+	two(tm.tm_sec);
+	memcpy(p," GMT",4);
+	p += 4;
+	return size_t(p - buf);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Parse an IMF-fixdate (the only form senders may generate). The
+// obsolete RFC 850 and asctime forms are not accepted.
+//////////////////////////////////////////////////////////////////////
+
+bool
+parse_http_date(const Slice& s,time_t& t) noexcept {
+	const char *p = s.data;
+	struct tm tm;
+	int mon = -1;
+
+	auto num = [](const char *p,int n,int& v) -> bool {
+		v = 0;
+		for ( int x=0; x<n; ++x ) {
+			if ( p[x] < '0' || p[x] > '9' )
+				return false;
+			v = v * 10 + (p[x] - '0');
+		}
+		return true;
+	};
+
+	if ( s.size != 29 || p[3] != ',' || p[4] != ' ' || p[7] != ' ' || p[11] != ' '
+	  || p[16] != ' ' || p[19] != ':' || p[22] != ':' || memcmp(p+25," GMT",4) != 0 )
+		return false;
+
+	for ( int x=0; x<12; ++x ) {
+		if ( !memcmp(p+8,months+x*3,3) ) {
+			mon = x;
+			break;
+		}
+	}
+	if ( mon < 0 )
+		return false;
+
+	memset(&tm,0,sizeof tm);
+	tm.tm_mon = mon;
+	if ( !num(p+5,2,tm.tm_mday) || !num(p+12,4,tm.tm_year)
+	  || !num(p+17,2,tm.tm_hour) || !num(p+20,2,tm.tm_min) || !num(p+23,2,tm.tm_sec) )
+		return false;
+	tm.tm_year -= 1900;
+	t = timegm(&tm);
+	return t != time_t(-1);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Reformat the Date: line when the second has changed:
+//////////////////////////////////////////////////////////////////////
+
+void
+DateCache::refresh(time_t now) noexcept {
+
+	if ( now == when && len > 0 )
+		return;				// Still current
+	when = now;
+	memcpy(text,"Date: ",6);
+	len = 6 + fmt_http_date(text+6,now);
+	memcpy(text+len,"\r\n",2);
+	len += 2;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Preformatted status lines (including CRLF):
+//////////////////////////////////////////////////////////////////////
+
+Slice
+Response::status_line(int code) noexcept {
+
+#define STATUS(code,text) case code: { \
+		static const char line[] = "HTTP/1.1 " #code " " text "\r\n"; \
+		return Slice(line,sizeof line - 1); }
+
+	switch ( code ) {
+	STATUS(100,"Continue")
+	STATUS(101,"Switching Protocols")
+	STATUS(200,"OK")
+	STATUS(201,"Created")
+	STATUS(202,"Accepted")
+	STATUS(204,"No Content")
+	STATUS(206,"Partial Content")
+	STATUS(301,"Moved Permanently")
+	STATUS(302,"Found")
+	STATUS(303,"See Other")
+	STATUS(304,"Not Modified")
+	STATUS(307,"Temporary Redirect")
+	STATUS(308,"Permanent Redirect")
+	STATUS(400,"Bad Request")
+	STATUS(401,"Unauthorized")
+	STATUS(403,"Forbidden")
+	STATUS(404,"Not Found")
+	STATUS(405,"Method Not Allowed")
+	STATUS(408,"Request Timeout")
+	STATUS(411,"Length Required")
+	STATUS(412,"Precondition Failed")
+	STATUS(413,"Payload Too Large")
+	STATUS(414,"URI Too Long")
+	STATUS(415,"Unsupported Media Type")
+	STATUS(416,"Range Not Satisfiable")
+	STATUS(417,"Expectation Failed")
+	STATUS(426,"Upgrade Required")
+	STATUS(429,"Too Many Requests")
+	STATUS(431,"Request Header Fields Too Large")
+	STATUS(500,"Internal Server Error")
+	STATUS(501,"Not Implemented")
+	STATUS(502,"Bad Gateway")
+	STATUS(503,"Service Unavailable")
+	STATUS(504,"Gateway Timeout")
+	STATUS(505,"HTTP Version Not Supported")
+	default:
+		return Slice();
+	}
+
+#undef STATUS
+}
+
+void
+Response::reset() noexcept {
+	hlen = 0;
+	n_iov = 1;			// iov[0] is always the header
+	body_len = 0;
+	overflowf = false;
+	endf = false;
+}
+
+void
+Response::append(const char *data,size_t bytes) noexcept {
+
+	if ( hlen + bytes > hdr_size ) {
+		overflowf = true;
+		return;
+	}
+	memcpy(hdr+hlen,data,bytes);
+	hlen += bytes;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Start the response with its status line. Codes without a
+// preformatted line are given a generic reason phrase.
+//////////////////////////////////////////////////////////////////////
+
+Response&
+Response::status(int code) noexcept {
+	Slice line = status_line(code);
+
+	reset();
+	if ( !line.empty() ) {
+		append(line.data,line.size);
+	} else	{
+		char buf[24];
+
+		append("HTTP/1.1 ",9);
+		append(buf,fmt_uint(buf,uint64_t(code < 0 ? 0 : code)));
+		append(" Unknown\r\n",10);
+	}
+	return *this;
+}
+
+Response&
+Response::header(const Slice& name,const Slice& value) noexcept {
+
+	if ( hlen + name.size + value.size + 4 > hdr_size ) {
+		overflowf = true;
+		return *this;
+	}
+	memcpy(hdr+hlen,name.data,name.size);
+	hlen += name.size;
+	hdr[hlen++] = ':';
+	hdr[hlen++] = ' ';
+	memcpy(hdr+hlen,value.data,value.size);
+	hlen += value.size;
+	hdr[hlen++] = '\r';
+	hdr[hlen++] = '\n';
+	return *this;
+}
+
+Response&
+Response::header(const Slice& name,uint64_t value) noexcept {
+	char buf[24];
+
+	return header(name,Slice(buf,fmt_uint(buf,value)));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Reference a body fragment (not copied):
+//////////////////////////////////////////////////////////////////////
+
+Response&
+Response::body(const void *data,size_t bytes) noexcept {
+
+	if ( !bytes )
+		return *this;
+	if ( n_iov >= max_iov ) {
+		overflowf = true;
+		return *this;
+	}
+	iov[n_iov].iov_base = (void *)data;
+	iov[n_iov].iov_len = bytes;
+	++n_iov;
+	body_len += bytes;
+	return *this;
+}
+
+Response&
+Response::end_headers() noexcept {
+
+	if ( !endf ) {
+		append("\r\n",2);
+		endf = true;
+	}
+	return *this;
+}
+
+Response&
+Response::finish() noexcept {
+
+	if ( !endf )
+		header(header_name(H_ContentLength),body_len);
+	return end_headers();
+}
+
+//////////////////////////////////////////////////////////////////////
+// The complete response, header first, for Service::writev():
+//////////////////////////////////////////////////////////////////////
+
+struct iovec *
+Response::iovec() noexcept {
+
+	iov[0].iov_base = hdr;
+	iov[0].iov_len = hlen;
+	return iov;
+}
+
+// End response.cpp
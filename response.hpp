@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////
+// response.hpp -- Preformatted HTTP response builder
+// Date: Mon Oct 19 14:10:27 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// Response formats the status line and headers into a fixed buffer
+// (no iostreams), and references body fragments as iovecs so that
+// the whole response goes out with one gather write. Body fragments
+// are not copied: they must remain valid until written.
+//
+// DateCache keeps the "Date:" header line, reformatted at most once
+// per second (each Scheduler owns one).
+///////////////////////////////////////////////////////////////////////
+
+#ifndef RESPONSE_HPP
+#define RESPONSE_HPP
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/uio.h>
+
+#include "utility.hpp"
+#include "hdrids.hpp"
+
+size_t fmt_http_date(char *buf,time_t t) noexcept;	// IMF-fixdate (29 bytes, no NUL)
+bool parse_http_date(const Slice& s,time_t& t) noexcept;
+
+//////////////////////////////////////////////////////////////////////
+// Cached Date: header line
+//////////////////////////////////////////////////////////////////////
+
+class DateCache {
+	time_t		when = 0;		// Second last formatted
+	char		text[48];		// "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+	size_t		len = 0;
+
+public:	DateCache() { refresh(::time(nullptr)); }
+
+	void refresh(time_t now) noexcept;
+	Slice line() const noexcept		{ return Slice(text,len); }
+	Slice value() const noexcept		{ return Slice(text+6,len-8); }
+};
+
+//////////////////////////////////////////////////////////////////////
+// Response builder
+//////////////////////////////////////////////////////////////////////
+
+class Response {
+public:	static const size_t hdr_size = 2048;	// Header buffer capacity
+	static const int max_iov = 16;		// Header + body fragments
+
+private:
+	char		hdr[hdr_size];		// Status line and headers
+	size_t		hlen;			// Bytes used in hdr[]
+	struct iovec	iov[max_iov];		// iov[0] is the header
+	int		n_iov;			// iov[] entries in use
+	uint64_t	body_len;		// Sum of body fragments
+	bool		overflowf;		// Header or iov[] capacity exceeded
+	bool		endf;			// Header block was terminated
+
+	void append(const char *data,size_t bytes) noexcept;
+
+public:	Response() { reset(); }
+
+	void reset() noexcept;
+
+	static Slice status_line(int code) noexcept;
+
+	Response& status(int code) noexcept;
+	Response& header(const Slice& name,const Slice& value) noexcept;
+	Response& header(const Slice& name,uint64_t value) noexcept;
+	Response& header(HeaderId id,const Slice& value) noexcept	{ return header(header_name(id),value); }
+	Response& header(HeaderId id,uint64_t value) noexcept		{ return header(header_name(id),value); }
+	Response& date(const DateCache& dc) noexcept			{ append(dc.line().data,dc.line().size); return *this; }
+	Response& body(const void *data,size_t bytes) noexcept;
+	Response& body(const Slice& s) noexcept				{ return body(s.data,s.size); }
+
+	Response& end_headers() noexcept;	// Terminate headers as is
+	Response& finish() noexcept;		// Add Content-Length and terminate
+
+	bool ok() const noexcept		{ return !overflowf; }
+	uint64_t body_size() const noexcept	{ return body_len; }
+	size_t size() const noexcept		{ return hlen + size_t(body_len); }
+	Slice headers() const noexcept		{ return Slice(hdr,hlen); }
+	struct iovec *iovec() noexcept;
+	int iovcnt() const noexcept		{ return n_iov; }
+};
+
+#endif // RESPONSE_HPP
+
+// End response.hpp
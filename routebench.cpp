@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////
+// routebench.cpp -- Benchmark of Router::match()
+// Date: Mon Oct 19 22:41:09 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "router.hpp"
+
+#define ROUTE(id) ((void *)(intptr_t)(id))
+
+static double
+elapsed(const timespec& t0) {
+	timespec t1;
+
+	clock_gettime(CLOCK_MONOTONIC,&t1);
+	return double(t1.tv_sec - t0.tv_sec) + double(t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Time n_loops passes of matching each path, and check the results:
+//////////////////////////////////////////////////////////////////////
+
+static void
+bench(const char *what,const Router& router,const std::vector<std::string>& paths,unsigned n_loops) {
+	Router::Match match;
+	size_t n = 0, matched = 0;
+	timespec t0;
+
+	clock_gettime(CLOCK_MONOTONIC,&t0);
+	for ( unsigned loop=0; loop < n_loops; ++loop ) {
+		for ( const auto& path : paths ) {
+			if ( router.match(Slice("GET",3),Slice(path.data(),path.size()),match) )
+				++matched;
+			++n;
+		}
+	}
+	double secs = elapsed(t0);
+
+	printf("%-28s %8.1f ns/match  (%zu of %zu matched)\n",what,secs * 1e9 / double(n),matched,n);
+	assert(matched == n);
+}
+
+int
+main(int argc,char **argv) {
+	const unsigned n_loops = argc > 1 ? unsigned(strtoul(argv[1],nullptr,10)) : 1000;
+	const unsigned n_resources = 1000;		// 3 routes each
+	std::vector<std::string> paths;
+	char pattern[128], path[128];
+	bool bf;
+
+	//////////////////////////////////////////////////////////////
+	// 3000 API routes, with parameters, plus a catch-all:
+	//////////////////////////////////////////////////////////////
+	{
+		Router router;
+
+		for ( unsigned x=0; x < n_resources; ++x ) {
+			snprintf(pattern,sizeof pattern,"/api/v1/res%u",x);
+			bf = router.add("GET",pattern,ROUTE(3*x+1));
+			snprintf(pattern,sizeof pattern,"/api/v1/res%u/:id",x);
+			bf = bf && router.add("GET",pattern,ROUTE(3*x+2));
+			snprintf(pattern,sizeof pattern,"/api/v1/res%u/:id/items/:item",x);
+			bf = bf && router.add("GET",pattern,ROUTE(3*x+3));
+			assert(bf);
+		}
+		bf = router.add("*","/*path",ROUTE(3*n_resources+1));
+		assert(bf);
+		router.compile();
+
+		srand(42);
+		for ( unsigned x=0; x < 4096; ++x ) {
+			unsigned r = unsigned(rand()) % n_resources;
+
+			switch ( x % 4 ) {
+			case 0:
+				snprintf(path,sizeof path,"/api/v1/res%u",r);
+				break;
+			case 1:
+				snprintf(path,sizeof path,"/api/v1/res%u/%u",r,x);
+				break;
+			case 2:
+				snprintf(path,sizeof path,"/api/v1/res%u/%u/items/%u?q=1",r,x,x * 7);
+				break;
+			default:
+				snprintf(path,sizeof path,"/api/v1/res%u/%u/other",r,x);	// Catch-all
+			}
+			paths.push_back(path);
+		}
+
+		printf("%zu routes, %zu paths\n",router.size(),paths.size());
+		bench("Router::match (API)",router,paths,n_loops);
+	}
+
+	//////////////////////////////////////////////////////////////
+	// Static and parameter branches at every segment (all 2^depth
+	// routes of "/a" or "/:pN"): the case that backtracking made
+	// exponential in the path depth, for a path that fails at the
+	// end (and falls to the wildcard):
+	//////////////////////////////////////////////////////////////
+	{
+		Router router;
+		const unsigned depth = Router::max_params;
+		std::string deep;
+
+		for ( unsigned bits=0; bits < (1u << depth); ++bits ) {
+			std::string pat;
+
+			for ( unsigned x=0; x < depth; ++x ) {
+				snprintf(pattern,sizeof pattern,"/:p%u",x);
+				pat.append(bits & (1u << x) ? pattern : "/a");
+			}
+			pat.append("/end");
+			bf = router.add("GET",pat.c_str(),ROUTE(bits+1));
+			assert(bf);
+		}
+		bf = router.add("GET","/*rest",ROUTE(1u << depth));
+		assert(bf);
+		router.compile();
+
+		for ( unsigned x=0; x < depth; ++x )
+			deep.append("/a");
+		deep.append("/z");
+
+		paths.clear();
+		paths.push_back(deep);
+		printf("%zu routes, depth %u\n",router.size(),depth);
+		bench("Router::match (deep)",router,paths,n_loops * 100);
+	}
+
+	return 0;
+}
+
+// End routebench.cpp
@@ -0,0 +1,364 @@
+//////////////////////////////////////////////////////////////////////
+// router.cpp -- Radix tree request router
+// Date: Mon Oct 19 11:52:36 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+
+#include "router.hpp"
+
+static const size_t jump_threshold = 4;		// Children before a jump table is compiled
+
+Router::Node::Node() {
+	for ( unsigned x=0; x < M_Count; ++x )
+		handlers[x] = nullptr;
+}
+
+Router::Node::~Node() {
+	for ( auto child : children )
+		delete child;
+	delete param;
+	delete wildcard;
+	delete[] jump;
+}
+
+bool
+Router::Node::terminal() const noexcept {
+
+	for ( unsigned x=0; x < M_Count; ++x )
+		if ( handlers[x] )
+			return true;
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the handler for method at node, else nullptr. HEAD requests
+// fall back to a GET route, and any method to an M_Any route.
+//////////////////////////////////////////////////////////////////////
+
+static inline void *
+handler_for(void * const *handlers,Router::Method method) noexcept {
+
+	if ( method >= Router::M_Any )
+		return handlers[Router::M_Any];
+	if ( handlers[method] )
+		return handlers[method];
+	if ( method == Router::M_HEAD && handlers[Router::M_GET] )
+		return handlers[Router::M_GET];
+	return handlers[Router::M_Any];
+}
+
+//////////////////////////////////////////////////////////////////////
+// Map a request method to Method
+//////////////////////////////////////////////////////////////////////
+
+Router::Method
+Router::method(const Slice& reqtype) noexcept {
+
+	switch ( reqtype.size ) {
+	case 3:
+		if ( reqtype.equals("GET",3) )
+			return M_GET;
+		if ( reqtype.equals("PUT",3) )
+			return M_PUT;
+		break;
+	case 4:
+		if ( reqtype.equals("POST",4) )
+			return M_POST;
+		if ( reqtype.equals("HEAD",4) )
+			return M_HEAD;
+		break;
+	case 5:
+		if ( reqtype.equals("PATCH",5) )
+			return M_PATCH;
+		if ( reqtype.equals("TRACE",5) )
+			return M_TRACE;
+		break;
+	case 6:
+		if ( reqtype.equals("DELETE",6) )
+			return M_DELETE;
+		break;
+	case 7:
+		if ( reqtype.equals("OPTIONS",7) )
+			return M_OPTIONS;
+		if ( reqtype.equals("CONNECT",7) )
+			return M_CONNECT;
+		break;
+	}
+	return M_Unknown;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Add a route. A method of "*" (or nullptr) routes any method:
+//
+// RETURNS:
+//	true	Route added
+//	false	Invalid pattern, duplicate route, or a parameter name
+//		conflicting with an existing route's at the same place
+//////////////////////////////////////////////////////////////////////
+
+bool
+Router::add(const char *method,const char *pattern,void *handler) {
+	Method m = !method || !strcmp(method,"*") ? M_Any : Router::method(Slice(method));
+
+	if ( m == M_Unknown || !pattern || *pattern != '/' || !handler )
+		return false;
+	if ( !insert(&root,pattern,m,handler) )
+		return false;
+	++n_routes;
+	return true;
+}
+
+bool
+Router::insert(Node *node,const char *pattern,Method method,void *handler) {
+	const char *start = pattern;
+
+	// True when pattern[x] begins a parameter or wildcard:
+	auto is_param = [start](const char *p) -> bool {
+		return (*p == ':' || *p == '*') && p > start && p[-1] == '/';
+	};
+
+	for (;;) {
+		if ( !*pattern ) {
+			if ( node->handlers[method] )
+				return false;		// Duplicate route
+			node->handlers[method] = handler;
+			return true;
+		}
+
+		if ( is_param(pattern) ) {
+			bool wildf = *pattern == '*';
+			size_t n = wildf ? strlen(pattern + 1) : strcspn(pattern + 1,"/");
+			Node *&child = wildf ? node->wildcard : node->param;
+
+			if ( !n )
+				return false;		// Unnamed parameter
+			if ( !child ) {
+				child = new Node;
+				child->name.assign(pattern + 1,n);
+			} else if ( child->name.compare(0,std::string::npos,pattern + 1,n) != 0 )
+				return false;		// Conflicting parameter name
+			node = child;
+			pattern += 1 + n;
+			continue;
+		}
+
+		//////////////////////////////////////////////////////
+		// Insert static text up to the next parameter:
+		//////////////////////////////////////////////////////
+
+		size_t n = 0;
+
+		while ( pattern[n] && !is_param(pattern + n) )
+			++n;
+
+		while ( n > 0 ) {
+			size_t x = node->firsts.find(*pattern), common = 0;
+
+			if ( x == std::string::npos ) {
+				Node *child = new Node;
+
+				child->prefix.assign(pattern,n);
+				node->children.push_back(child);
+				node->firsts.push_back(*pattern);
+				delete[] node->jump;
+				node->jump = nullptr;
+				node = child;
+				pattern += n;
+				break;
+			}
+
+			Node *child = node->children[x];
+			const std::string& prefix = child->prefix;
+
+			while ( common < n && common < prefix.size() && prefix[common] == pattern[common] )
+				++common;
+
+			if ( common < prefix.size() ) {
+				// Split child's edge at common:
+				Node *mid = new Node;
+
+				mid->prefix.assign(prefix,0,common);
+				child->prefix.erase(0,common);
+				mid->children.push_back(child);
+				mid->firsts.push_back(child->prefix[0]);
+				node->children[x] = mid;
+				child = mid;
+			}
+			node = child;
+			pattern += common;
+			n -= common;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Compile first byte jump tables for nodes with many children. Call
+// after routes are added (adding routes afterwards is permitted, but
+// discards the affected node's table).
+//////////////////////////////////////////////////////////////////////
+
+void
+Router::compile() {
+	compile(&root);
+}
+
+void
+Router::compile(Node *node) {
+
+	if ( node->children.size() > jump_threshold && !node->jump ) {
+		node->jump = new uint16_t[256];
+		memset(node->jump,0,256 * sizeof(uint16_t));
+		for ( size_t x=0; x < node->firsts.size(); ++x )
+			node->jump[(unsigned char)node->firsts[x]] = uint16_t(x + 1);
+	}
+	for ( auto child : node->children )
+		compile(child);
+	if ( node->param )
+		compile(node->param);
+	if ( node->wildcard )
+		compile(node->wildcard);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Match a request. Any query string in path is ignored:
+//
+// RETURNS:
+//	true	Route matched: m.handler and parameters are set
+//	false	No route. m.mismatchf is true if the path matched a
+//		route, but not for this method (405).
+//////////////////////////////////////////////////////////////////////
+
+bool
+Router::match(const Slice& method,const Slice& path,Match& m) const noexcept {
+	const char *q = (const char *)memchr(path.data,'?',path.size);
+
+	m.handler = nullptr;
+	m.mismatchf = false;
+	m.n_params = 0;
+	return lookup(&root,path.data,q ? q : path.end(),Router::method(method),m);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Walk the tree without backtracking. Static text is followed while
+// it matches; once it has matched a whole segment (up to the next
+// '/'), lookup is committed to it. If static text fails within a
+// segment, the parameter at that segment's start (if any) is taken
+// instead, rescanning only that segment. If the walk fails, the
+// deepest wildcard passed that routes the method matches the rest of
+// the path. Each path byte is examined at most twice: lookup is
+// O(path length), regardless of the number of routes.
+//////////////////////////////////////////////////////////////////////
+
+bool
+Router::lookup(const Node *node,const char *p,const char *e,Method method,Match& m) const noexcept {
+	const Node *pnode = nullptr;		// Parameter alternative for this segment
+	const char *pp = nullptr;		// Start of that segment
+	const Node *wnode = nullptr;		// Deepest wildcard routing method
+	const char *wp = nullptr;		// Path matched by it
+	unsigned wparams = 0;			// Parameters before it
+	bool wmismatchf = false;		// A wildcard passed routes other methods
+	void *handler;
+
+	for (;;) {
+		if ( node->wildcard ) {
+			if ( handler_for(node->wildcard->handlers,method) ) {
+				wnode = node->wildcard;
+				wp = p;
+				wparams = m.n_params;
+			} else if ( node->wildcard->terminal() )
+				wmismatchf = true;
+		}
+
+		if ( p == e ) {
+			if ( (handler = handler_for(node->handlers,method)) != nullptr ) {
+				m.handler = handler;
+				return true;
+			}
+			if ( node->terminal() )
+				m.mismatchf = true;
+		} else	{
+			const Node *child = nullptr;
+
+			if ( node->param ) {
+				pnode = node;		// At a segment start
+				pp = p;
+			}
+
+			if ( node->jump ) {
+				unsigned x = node->jump[(unsigned char)*p];
+
+				if ( x )
+					child = node->children[x - 1];
+			} else	{
+				const char *f = (const char *)memchr(node->firsts.data(),*p,node->firsts.size());
+
+				if ( f )
+					child = node->children[f - node->firsts.data()];
+			}
+
+			if ( child ) {
+				size_t n = child->prefix.size();
+
+				if ( size_t(e - p) >= n && !memcmp(p,child->prefix.data(),n) ) {
+					if ( pnode && memchr(p,'/',n) )
+						pnode = nullptr;	// Segment matched: committed
+					node = child;
+					p += n;
+					continue;
+				}
+			}
+		}
+
+		if ( !pnode || m.n_params >= max_params )
+			break;
+
+		// Static text failed within the segment: take the parameter
+		const char *q = (const char *)memchr(pp,'/',size_t(e - pp));
+
+		if ( !q )
+			q = e;
+		if ( q == pp )
+			break;				// Empty segment
+		m.names[m.n_params] = Slice(pnode->param->name.data(),pnode->param->name.size());
+		m.values[m.n_params++] = Slice(pp,size_t(q - pp));
+		node = pnode->param;
+		p = q;
+		pnode = nullptr;
+	}
+
+	if ( wnode ) {
+		m.n_params = wparams;
+		if ( m.n_params < max_params ) {
+			m.names[m.n_params] = Slice(wnode->name.data(),wnode->name.size());
+			m.values[m.n_params++] = Slice(wp,size_t(e - wp));
+		}
+		m.handler = handler_for(wnode->handlers,method);
+		return true;
+	}
+	if ( wmismatchf )
+		m.mismatchf = true;
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Return the value of parameter name, else nullptr
+//////////////////////////////////////////////////////////////////////
+
+const Slice *
+Router::Match::param(const char *name) const noexcept {
+	size_t len = strlen(name);
+
+	for ( unsigned x=0; x < n_params; ++x )
+		if ( names[x].equals(name,len) )
+			return &values[x];
+	return nullptr;
+}
+
+// End router.cpp
@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////
+// router.hpp -- Radix tree request router
+// Date: Mon Oct 19 11:48:03 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#ifndef ROUTER_HPP
+#define ROUTER_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "utility.hpp"
+
+//////////////////////////////////////////////////////////////////////
+// Routes method + path patterns to handlers. Patterns are made of
+// static text, ":name" parameters matching one path segment, and a
+// trailing "*name" wildcard matching the rest of the path:
+//
+//	router.add("GET","/users/:id/posts/*rest",handler);
+//
+// Routes are held in a compressed radix tree. Lookup is allocation
+// free, extracting parameters as slices of the request path. Static
+// text has priority over a parameter, which has priority over a
+// wildcard. A path segment matched in full by static text commits
+// the lookup to that branch (there is no backtracking to a parameter
+// for it): when the rest does not match, the deepest wildcard passed
+// applies. Lookup is linear in the path length.
+//////////////////////////////////////////////////////////////////////
+
+class Router {
+public:	enum Method {
+		M_GET, M_HEAD, M_POST, M_PUT, M_DELETE,
+		M_PATCH, M_OPTIONS, M_CONNECT, M_TRACE,
+		M_Any,				// Route for any method
+		M_Count,
+		M_Unknown = M_Count
+	};
+
+	static const unsigned max_params = 8;
+
+	struct Match {
+		void		*handler=nullptr;	// Handler of matched route
+		bool		mismatchf=false;	// Path matched, but not the method
+		unsigned	n_params=0;		// Number of parameters
+		Slice		names[max_params];	// Parameter names
+		Slice		values[max_params];	// Parameter values (within path)
+
+		const Slice *param(const char *name) const noexcept;
+	};
+
+private:
+	struct Node {
+		std::string	prefix;			// Static text of this edge
+		std::vector<Node*> children;		// Static children
+		std::string	firsts;			// First byte of each child's prefix
+		uint16_t	*jump=nullptr;		// Compiled: first byte -> child x+1
+		Node		*param=nullptr;		// ":name" child
+		Node		*wildcard=nullptr;	// "*name" child
+		std::string	name;			// Parameter name (param/wildcard)
+		void		*handlers[M_Count];	// Handlers by method
+
+		Node();
+		~Node();
+		bool terminal() const noexcept;
+	};
+
+	Node		root;
+	size_t		n_routes=0;
+
+	bool insert(Node *node,const char *pattern,Method method,void *handler);
+	bool lookup(const Node *node,const char *p,const char *e,Method method,Match& m) const noexcept;
+	void compile(Node *node);
+
+public:	Router() {}
+	Router(const Router&) = delete;
+	Router& operator=(const Router&) = delete;
+
+	bool add(const char *method,const char *pattern,void *handler);
+	void compile();
+	bool match(const Slice& method,const Slice& path,Match& m) const noexcept;
+	size_t size() const noexcept		{ return n_routes; }
+
+	static Method method(const Slice& reqtype) noexcept;
+};
+
+#endif // ROUTER_HPP
+
+// End router.hpp
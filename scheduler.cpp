@@ -10,8 +10,16 @@
 #include <errno.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <limits.h>
 #include <assert.h>
 
+#include <algorithm>
+
 #include "scheduler.hpp"
 
 Scheduler::Scheduler() {
@@ -59,6 +67,23 @@ Scheduler::add(int fd,uint32_t events,Service *co) {
 	return !rc;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Run a new service in the current wakeup, after those already ready,
+// before its socket is registered with epoll(2): a connection whose
+// request is already queued (see TCP_DEFER_ACCEPT) is read at once,
+// rather than after another epoll_wait(2). The socket is added with
+// events when the service first yields (to wait for I/O). If that
+// fails (ENOMEM, or ENOSPC from max_user_watches), the service could
+// never be woken: its socket is closed and the service deleted.
+//////////////////////////////////////////////////////////////////////
+
+void
+Scheduler::start(Service& svc,uint32_t events) {
+
+	svc.add_events = events;
+	service_list.push_back(svc);
+}
+
 bool
 Scheduler::chg(int fd,Events& ev,CoroutineBase *co) {
 	struct epoll_event evt;
@@ -76,25 +101,34 @@ Scheduler::chg(int fd,Events& ev,CoroutineBase *co) {
 void
 Scheduler::run() {
 	static const int max_events = 8*1024;
-	typedef boost::intrusive::member_hook<Service,EvNode,&Service::evnode> EvMemberHook;
-	typedef boost::intrusive::list<Service,EvMemberHook,non_constant_time_size,auto_unlink> EvObjList;
 	epoll_event events[max_events];
-	EvObjList service_list;
 	struct s_timer_parms {
 		size_t		timerx;		// Timer index
 		Scheduler	*pscheduler;	// Scheduler pointer
+		unsigned	resumed;	// Services resumed by timers
 	} timer_parms;
-	timespec now;
+	timespec now, wait_start, busy_end, cpu0, cpu1;
 	int rc, n_events;
+	unsigned n_run;
+
+	auto nsecs = [](timespec a,const timespec& b) -> long {
+		a -= b;
+		return a.tv_sec * 1000000000L + a.tv_nsec;
+	};
 
 	timer_parms.pscheduler = this;
+	::timeofday(wait_start);
 
 	for (;;) {
 		rc = epoll_wait(efd,&events[0],max_events,10);
+		::timeofday(now);
+		datecache.refresh(now.tv_sec);
+
 		if ( rc > 0 ) {
 			n_events = rc;
+			::clock_gettime(CLOCK_THREAD_CPUTIME_ID,&cpu0);
+			timer_parms.resumed = 0;
 
-			service_list.clear();
 			for ( int x=0; x<n_events; ++x ) {
 				Service& svc = *(Service*)events[x].data.ptr;
 
@@ -109,6 +143,7 @@ Scheduler::run() {
 				Scheduler& sched = *tparms.pscheduler;
 
 				service.timeout(tparms.timerx);
+				++tparms.resumed;
 				if ( !sched.yield(service) ) {
 					delete &service;
 				} else	{
@@ -117,27 +152,42 @@ Scheduler::run() {
 				}
 			};
 
-			::timeofday(now);
-
 			for ( timer_parms.timerx=0; timer_parms.timerx < timers.size(); ++timer_parms.timerx )
 				timers[timer_parms.timerx].expire(now,callback,&timer_parms);
 
-			while ( !service_list.empty() ) {
+			for ( n_run = 0; !service_list.empty(); ++n_run ) {
 				Service& svc = service_list.front();
 
 				service_list.pop_front();
 				if ( !yield(svc) ) {			// Invoke service coroutine
 					delete &svc;			// Coroutine has terminated
 				} else	{
+					if ( svc.add_events ) {		// First yield after start()
+						if ( !add(svc.socket(),svc.add_events,&svc) ) {
+							::close(svc.socket());	// Never woken: drop it
+							delete &svc;
+							continue;
+						}
+						svc.add_events = 0;
+					}
 					svc.ev.disable_ev(svc.er_flags);	// No longer require notification of seen errors
 					if ( svc.ev.sync_ev() )			// Changes to desired event notifications?
 						chg(svc.socket(),svc.ev,&svc);	// Yes, make them so
 				}
 			}
 
-		} else if ( rc < 0 ) {
-			printf("Scheduler: %s: epoll_wait()\n",
-				strerror(errno));
+			::timeofday(busy_end);
+			::clock_gettime(CLOCK_THREAD_CPUTIME_ID,&cpu1);
+			load.sample(nsecs(busy_end,now),nsecs(now,wait_start),unsigned(n_events),
+				n_run + timer_parms.resumed,nsecs(cpu1,cpu0));
+			wait_start = busy_end;
+
+		} else	{
+			if ( rc < 0 )
+				printf("Scheduler: %s: epoll_wait()\n",
+					strerror(errno));
+			load.sample(0,nsecs(now,wait_start),0,0,0);
+			wait_start = now;
 		}
 	}
 
@@ -190,6 +240,412 @@ Service::write_sock(int fd,const void *buf,size_t bytes) {
 	return -errno;					// Should never get here
 }
 
+//////////////////////////////////////////////////////////////////////
+// Gather write of iov[0..iovcnt-1], yielding until writable:
+//
+// RETURNS:
+//	< 0	Fatal error (-errno)
+//	>= 0	Bytes written by the one writev(2)/sendmsg(2) call
+// NOTES:
+//	1. flags are sendmsg(2) flags (MSG_MORE etc.) When zero, a
+//	   plain writev(2) is used.
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::write_sockv(int fd,const struct iovec *iov,int iovcnt,int flags) {
+	struct msghdr msg;
+	int rc;
+
+	if ( flags ) {
+		memset(&msg,0,sizeof msg);
+		msg.msg_iov = (struct iovec *)iov;
+		msg.msg_iovlen = iovcnt;
+	}
+
+	for (;;) {
+		if ( flags )
+			rc = ::sendmsg(fd,&msg,flags);
+		else	rc = ::writev(fd,iov,iovcnt);
+		if ( rc < 0 ) {
+			switch ( errno ) {
+			case EINTR:
+				break;			// Signaled, retry..
+			case EWOULDBLOCK:
+				yield();		// Unable to write, yet.
+				break;
+			default:
+				return -errno;		// Fail..
+			}
+		} else	{
+			return rc;			// Return what we've written
+		}
+	}
+	return -errno;					// Should never get here
+}
+
+//////////////////////////////////////////////////////////////////////
+// Send count bytes of file in_fd from offset with sendfile(2), so
+// that file content goes from the page cache to the socket without
+// passing through user space. Yields while the socket is full.
+//
+// RETURNS:
+//	< 0	Error (-errno, or -EIO if the file was truncated)
+//	1	Success
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::send_file(int fd,int in_fd,off_t offset,size_t count) {
+	static const size_t max_send = 0x7FFFF000;	// Linux limit per call
+	ssize_t rc;
+
+	while ( count > 0 ) {
+		rc = ::sendfile(fd,in_fd,&offset,count > max_send ? max_send : count);
+		if ( rc < 0 ) {
+			switch ( errno ) {
+			case EINTR:
+				break;			// Signaled, retry..
+			case EWOULDBLOCK:
+				yield();		// Unable to write, yet.
+				break;
+			default:
+				return -errno;		// Fail..
+			}
+		} else if ( rc == 0 ) {
+			return -EIO;			// File shrank underneath us
+		} else	{
+			count -= size_t(rc);
+		}
+	}
+	return 1;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write all fragments iov[0..iovcnt-1] with as few system calls as
+// possible, resuming after partial writes:
+//
+// ARGUMENTS:
+//	more	When true, MSG_MORE is applied so that the kernel
+//		holds back a partial segment, expecting more data
+//		(for example the next pipelined response). Unix
+//		domain sockets have no segments, and use writev(2).
+// RETURNS:
+//	< 0	Error
+//	1	Success
+// NOTES:
+//	1. iov[] is updated in place as data is written.
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::writev(int fd,struct iovec *iov,int iovcnt,bool more) {
+	size_t n;
+	int rc, cnt;
+
+	for (;;) {
+		while ( iovcnt > 0 && iov->iov_len == 0 ) {
+			++iov;				// Skip empty fragments
+			--iovcnt;
+		}
+		if ( iovcnt <= 0 )
+			return 1;			// Success
+
+		cnt = iovcnt > IOV_MAX ? IOV_MAX : iovcnt;
+		rc = write_sockv(fd,iov,cnt,(more || cnt < iovcnt) && (tcpf || fd != sock) ? MSG_MORE : 0);
+		if ( rc < 0 )
+			return rc;			// Fail
+
+		// Advance past what was written:
+		for ( n = size_t(rc); iovcnt > 0 && n >= iov->iov_len; ++iov, --iovcnt )
+			n -= iov->iov_len;
+		if ( n > 0 ) {
+			iov->iov_base = (char *)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write buffers bufs[0..nbufs-1] with gather writes, max_bufs at a
+// time (one write for the usual header and body):
+//
+// RETURNS:
+//	< 0	Error
+//	1	Success
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::write(int fd,HttpBuf *bufs[],int nbufs,bool more) {
+	static const int max_bufs = 8;		// Buffers per gather write
+	std::string strs[max_bufs];
+	struct iovec iov[max_bufs];
+	int n, rc = 1;
+
+	for ( int x=0; x<nbufs && rc > 0; x += n ) {
+		n = std::min(nbufs - x,max_bufs);
+		for ( int y=0; y<n; ++y ) {
+			strs[y] = bufs[x+y]->str();
+			iov[y].iov_base = (void *)strs[y].data();
+			iov[y].iov_len = strs[y].size();
+		}
+		rc = writev(fd,iov,n,more || x + n < nbufs);
+	}
+	return rc;
+}
+
+int
+Service::write(int fd,HttpBuf& hdr,HttpBuf& body,bool more) {
+	HttpBuf *bufs[2] = { &hdr, &body };
+
+	return write(fd,bufs,2,more);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write a built Response (header and referenced body fragments) in
+// one gather write. The headers should be terminated by finish() or
+// end_headers().
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::write(int fd,Response& resp,bool more) {
+
+	if ( !resp.ok() )
+		return -ENOBUFS;
+	return writev(fd,resp.iovec(),resp.iovcnt(),more);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set or clear TCP_CORK on a TCP socket. While corked, partial
+// segments are held back until uncorked (or 200ms elapses). A unix
+// domain socket has no segments: this is a no-op for it.
+//////////////////////////////////////////////////////////////////////
+
+bool
+Service::cork(int fd,bool on) noexcept {
+	int v = on ? 1 : 0;
+
+	if ( fd == sock && !tcpf )
+		return true;
+
+	return !setsockopt(fd,IPPROTO_TCP,TCP_CORK,&v,sizeof v);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Begin a streamed response. The header buffer hdr holds the status
+// line and headers, without the terminating empty line. When
+// content_length is negative, Transfer-Encoding: chunked is used,
+// else Content-Length is declared. Body data follows with calls to
+// write_body(), and the response is completed by end_response().
+//
+// RETURNS:
+//	< 0	Error
+//	1	Success
+// NOTES:
+//	1. EPOLLOUT is enabled for the duration of the response, so
+//	   that writes suspend the coroutine while the socket buffer
+//	   is full (back pressure).
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::begin_response(int fd,HttpBuf& hdr,long content_length) {
+
+	if ( content_length < 0 ) {
+		hdr << "Transfer-Encoding: chunked\r\n\r\n";
+		resp_mode = R_Chunked;
+		resp_left = 0;
+	} else	{
+		hdr << "Content-Length: " << content_length << "\r\n\r\n";
+		resp_mode = R_Length;
+		resp_left = size_t(content_length);
+	}
+
+	ev.enable_ev(EPOLLOUT);
+
+	std::string h(hdr.str());
+	struct iovec iov[1];
+
+	iov[0].iov_base = (void *)h.data();
+	iov[0].iov_len = h.size();
+	return writev(fd,iov,1,content_length != 0);	// Body follows
+}
+
+//////////////////////////////////////////////////////////////////////
+// With level > 0, the body is compressed in the given coding (gzip or
+// zstd) as it is written, at zlib level (or the zstd level of similar
+// cost): Content-Encoding is declared and chunked framing is used,
+// since the compressed length is not known in advance. Callers decide
+// whether compression pays (see Gzip::compressible() and
+// Scheduler::compression_level()). zstd falls back to gzip when
+// libzstd is not available.
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::begin_response(int fd,Response& resp,long content_length,int level,Encoding coding) {
+	static const Slice chunked("chunked");
+
+	zout.reset();
+	zsout.reset();
+	if ( level > 0 && coding != E_Identity ) {
+		if ( coding == E_Zstd && Zstd::available ) {
+			resp.header(H_ContentEncoding,"zstd");
+			zsout = ZstdPool::local().get(Zstd::Compress,zout_cb,Zstd::level_for(level));
+		} else	{
+			resp.header(H_ContentEncoding,"gzip");
+			zout = ZlibPool::local().get(ZlibPool::GzipDeflate,zout_cb,level);
+		}
+		resp.header(H_Vary,"Accept-Encoding");
+		zout_fd = fd;
+		zout_err = 0;
+		content_length = -1;
+	}
+
+	if ( content_length < 0 ) {
+		resp.header(H_TransferEncoding,chunked);
+		resp_mode = R_Chunked;
+		resp_left = 0;
+	} else	{
+		resp.header(H_ContentLength,uint64_t(content_length));
+		resp_mode = R_Length;
+		resp_left = size_t(content_length);
+	}
+	resp.end_headers();
+	if ( !resp.ok() )
+		return -ENOBUFS;
+
+	ev.enable_ev(EPOLLOUT);
+
+	struct iovec iov[1];
+
+	iov[0].iov_base = (void *)resp.headers().data;
+	iov[0].iov_len = resp.headers().size;
+	return writev(fd,iov,1,content_length != 0);	// Body follows
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write the next part of a streamed response body:
+//
+// RETURNS:
+//	< 0	Error (-EINVAL if more than Content-Length is written,
+//		or no response was begun)
+//	1	Success
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::write_body(int fd,const void *buf,size_t bytes) {
+	struct iovec iov[1];
+
+	if ( bytes <= 0 )
+		return 1;			// Nothing to write (an empty chunk would end the body)
+
+	if ( zout || zsout ) {
+		int zrc = zout ? zout->compress((void *)buf,bytes,this)	// Output goes to zout_cb()
+			: zsout->compress((void *)buf,bytes,this);
+
+		if ( zout_err )
+			return zout_err;
+		return zrc == Z_OK ? 1 : -EIO;
+	}
+
+	switch ( resp_mode ) {
+	case R_Length:
+		if ( bytes > resp_left )
+			return -EINVAL;
+		resp_left -= bytes;
+		iov[0].iov_base = (void *)buf;
+		iov[0].iov_len = bytes;
+		return writev(fd,iov,1,resp_left > 0);
+
+	case R_Chunked:
+		return write_chunk(fd,buf,bytes);
+
+	default:
+		return -EINVAL;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// Write one chunk of a chunked response body:
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::write_chunk(int fd,const void *buf,size_t bytes) {
+	struct iovec iov[3];
+	char size[24];
+
+	iov[0].iov_base = size;
+	iov[0].iov_len = fmt_hex(size,bytes);
+	memcpy(size+iov[0].iov_len,"\r\n",2);
+	iov[0].iov_len += 2;
+	iov[1].iov_base = (void *)buf;
+	iov[1].iov_len = bytes;
+	iov[2].iov_base = (void *)"\r\n";
+	iov[2].iov_len = 2;
+	return writev(fd,iov,3,true);		// At least the last chunk follows
+}
+
+//////////////////////////////////////////////////////////////////////
+// Zlib and Zstd output callback: each block of compressed output
+// becomes a chunk. Callbacks cannot fail, so the first error is kept
+// for write_body() and end_response() to report.
+//////////////////////////////////////////////////////////////////////
+
+void
+Service::zout_cb(void *buf,size_t bytes,void *arg) {
+	Service& svc = *(Service *)arg;
+	int rc;
+
+	if ( svc.zout_err || !bytes )
+		return;				// Discard output after an error
+	rc = svc.write_chunk(svc.zout_fd,buf,bytes);
+	if ( rc < 0 )
+		svc.zout_err = rc;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Complete a streamed response:
+//
+// RETURNS:
+//	< 0	Error (-EINVAL if Content-Length was not satisfied)
+//	1	Success
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::end_response(int fd) {
+	static const char last_chunk[] = "0\r\n\r\n";
+	struct iovec iov[1];
+	int rc = 1;
+
+	if ( zout || zsout ) {
+		rc = zout ? zout->finish(this) : zsout->finish(this);	// Flush compressed output
+		rc = zout_err ? zout_err : rc == Z_OK ? 0 : -EIO;
+		zout.reset();
+		zsout.reset();
+		if ( rc < 0 ) {
+			resp_mode = R_None;
+			ev.disable_ev(EPOLLOUT);
+			return rc;
+		}
+		rc = 1;
+	}
+
+	switch ( resp_mode ) {
+	case R_Length:
+		if ( resp_left > 0 )
+			rc = -EINVAL;		// Short response
+		break;
+	case R_Chunked:
+		iov[0].iov_base = (void *)last_chunk;
+		iov[0].iov_len = sizeof last_chunk - 1;
+		rc = writev(fd,iov,1,false);
+		break;
+	default:
+		rc = -EINVAL;
+	}
+
+	resp_mode = R_None;
+	resp_left = 0;
+	ev.disable_ev(EPOLLOUT);
+	return rc;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Read until http buffer complete in buf:
 //
@@ -217,6 +673,21 @@ Service::read_body(int fd,HttpBuf& buf,size_t content_length) {
 	return buf.read_body(fd,read_cb,this,content_length);
 }
 
+//////////////////////////////////////////////////////////////////////
+// Stream the next part of the body into dst, after a call to
+// HttpBuf::begin_body(). Handles Content-Length and chunked bodies:
+//
+// RETURNS:
+//	< 0	Fatal error
+//	0	End of body
+//	> 0	Number of body bytes placed into dst
+//////////////////////////////////////////////////////////////////////
+
+int
+Service::read_body_chunk(int fd,HttpBuf& buf,void *dst,size_t bytes) {
+	return buf.read_body_chunk(fd,read_cb,this,dst,bytes);
+}
+
 int
 Service::write(int fd,HttpBuf& buf) {
 	return buf.write(fd,write_cb,this);
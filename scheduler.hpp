@@ -8,14 +8,24 @@
 
 #include <stdint.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/types.h>
 #include <unordered_map>
 #include <vector>
+#include <memory>
 #include <exception>
 
 #include "coroutine.hpp"
 #include "events.hpp"
 #include "sockets.hpp"
 #include "httpbuf.hpp"
+#include "arena.hpp"
+#include "response.hpp"
+#include "rcache.hpp"
+#include "gzip.hpp"
+#include "zstd.hpp"
+#include "load.hpp"
+#include "negotiate.hpp"
 #include "evtimer.hpp"
 
 class Scheduler;
@@ -33,6 +43,22 @@ class Service : public Coroutine {
 	uint32_t	er_flags=0;		// Error flags received (EPOLLHUP etc.)
 	uint32_t	ev_flags=0;		// Event flags recevied (EPOLLIN|EPOLLOUT|error flags seen this time only)
 	size_t		timerx=~size_t(0);	// Index of active timer (Scheduler::no_timer)
+	uint32_t	add_events=0;		// Register with these on first yield (Scheduler::start())
+	bool		tcpf=true;		// sock is TCP (not AF_UNIX): cork() applies
+
+	enum {
+		R_None,				// No streamed response in progress
+		R_Length,			// Streaming with Content-Length
+		R_Chunked			// Streaming with Transfer-Encoding: chunked
+	}		resp_mode=R_None;
+	size_t		resp_left=0;		// Content-Length bytes remaining (R_Length)
+	ZlibPtr		zout;			// Response body compressor (gzip coding)
+	ZstdPtr		zsout;			// Response body compressor (zstd coding)
+	int		zout_fd=-1;		// Socket receiving compressed output
+	int		zout_err=0;		// First error writing compressed output
+	std::unique_ptr<Response> resp;		// Response builder (response())
+	std::unique_ptr<Arena> arenap;		// Per-request storage (arena())
+	std::unique_ptr<char[]> iobuf;		// Scratch I/O buffer (io_buffer())
 
 public:
 	EvNode		tmrnode;		// Timer event node (Scheduler timer)
@@ -41,6 +67,8 @@ public:
 private:
 	static int read_cb(int fd,void *buf,size_t bytes,void *arg);
 	static int write_cb(int fd,const void *buf,size_t bytes,void *arg);
+	static void zout_cb(void *buf,size_t bytes,void *arg);
+	int write_chunk(int fd,const void *buf,size_t bytes);
 
 public:	struct Timeout : public std::exception {
 		size_t	timerx;			// Index of expired timer
@@ -48,7 +76,11 @@ public:	struct Timeout : public std::exception {
 		Timeout(size_t x) : timerx(x) {};
 	};
 
-public:	Service(fun_t func,int fd) : Coroutine(func), sock(fd), tmrnode(), evnode() {}
+public:	static const size_t default_stack = 64*1024;	// Coroutine stack: handler frames, zlib and zstd
+	static const size_t io_size = 4096;		// io_buffer() bytes
+
+	Service(fun_t func,int fd,size_t stacksize=default_stack)
+	  : Coroutine(func,stacksize), sock(fd), tmrnode(), evnode() {}
 	~Service() { }
 
 	static Service& service(CoroutineBase *co);
@@ -58,14 +90,35 @@ public:	Service(fun_t func,int fd) : Coroutine(func), sock(fd), tmrnode(), evnod
 	Events &events() noexcept		{ return ev; }
 	uint32_t err_flags() noexcept		{ return er_flags; }
 	uint32_t evt_flags() noexcept		{ return ev_flags; }
+	bool is_tcp() const noexcept		{ return tcpf; }
+	void set_tcp(bool tcp) noexcept		{ tcpf = tcp; }
+
+	// Kept off the (small) coroutine stack, and freed with the Service:
+	Response& response()			{ if ( !resp ) resp.reset(new Response); return *resp; }
+	char *io_buffer()			{ if ( !iobuf ) iobuf.reset(new char[io_size]); return iobuf.get(); }
+	Arena& arena()				{ if ( !arenap ) arenap.reset(new Arena); return *arenap; }
 
 	int read_header(int fd,HttpBuf& buf);
 	int write(int fd,HttpBuf& buf);
+	int write(int fd,HttpBuf& hdr,HttpBuf& body,bool more=false);
+	int write(int fd,HttpBuf *bufs[],int nbufs,bool more=false);
+	int write(int fd,Response& resp,bool more=false);
+	int writev(int fd,struct iovec *iov,int iovcnt,bool more=false);
+	bool cork(int fd,bool on) noexcept;
+
+	int begin_response(int fd,HttpBuf& hdr,long content_length=-1);
+	int begin_response(int fd,Response& resp,long content_length=-1,int level=0,
+		Encoding coding=E_Gzip);
+	int write_body(int fd,const void *buf,size_t bytes);
+	int end_response(int fd);
 
 	int read_body(int fd,HttpBuf& buf,size_t content_length);
 	int read_chunked(int fd,HttpBuf& buf,std::stringstream& unchunked);
+	int read_body_chunk(int fd,HttpBuf& buf,void *dst,size_t bytes);
 	int read_sock(int fd,void *buf,size_t bytes);
 	int write_sock(int fd,const void *buf,size_t bytes);
+	int write_sockv(int fd,const struct iovec *iov,int iovcnt,int flags=0);
+	int send_file(int fd,int in_fd,off_t offset,size_t count);
 
 	CoroutineBase *yield();
 	void timeout(size_t timerx)		{ this->timerx = timerx; }
@@ -78,10 +131,19 @@ public:	Service(fun_t func,int fd) : Coroutine(func), sock(fd), tmrnode(), evnod
 //////////////////////////////////////////////////////////////////////
 
 class Scheduler : public CoroutineMain {
+	typedef boost::intrusive::member_hook<Service,EvNode,&Service::evnode> EvMemberHook;
+	typedef boost::intrusive::list<Service,EvMemberHook,non_constant_time_size,auto_unlink> EvObjList;
+
 	int		efd = -1;		// From epoll_create1()
+	EvObjList	service_list;		// Services to run this wakeup
 
 	std::vector<EvTimer<Service>> timers;
 	std::unordered_map<int/*fd*/,CoroutineBase*> fdset;
+	DateCache	datecache;		// Date: header, refreshed each second
+	ResponseCache	rcache;			// This scheduler's response cache shard
+	LoadStats	load;			// Event loop load averages
+	CompressPolicy	cpolicy;		// Compression level by load
+	Negotiator	negotiator;		// Memoized Accept-Encoding results
 
 public:	Scheduler();
 	~Scheduler();
@@ -90,8 +152,15 @@ public:	Scheduler();
 	void run();
 
 	void sync(Events& ev) noexcept;
+	const DateCache& date() const noexcept	{ return datecache; }
+	ResponseCache& response_cache() noexcept { return rcache; }
+	const LoadStats& load_stats() const noexcept { return load; }
+	CompressPolicy& compress_policy() noexcept { return cpolicy; }
+	int compression_level() const noexcept	{ return cpolicy.level(load); }
+	Accept accept_encoding(const Slice *header) noexcept { return negotiator.accept_encoding(header); }
 
 	bool add(int fd,uint32_t events,Service *co);
+	void start(Service& svc,uint32_t events);
 	bool del(int fd);
 	bool chg(int fd,Events& ev,CoroutineBase *co);
 
@@ -11,46 +11,89 @@
 #include <string.h>
 #include <assert.h>
 
+#include <algorithm>
+
 #include "scheduler.hpp"
 #include "httpbuf.hpp"
+#include "arena.hpp"
+#include "headers.hpp"
+#include "router.hpp"
+#include "query.hpp"
 #include "parse.hpp"
+#include "response.hpp"
+#include "files.hpp"
+#include "gzip.hpp"
+#include "inflate.hpp"
+#include "acceptor.hpp"
+#include "dgram.hpp"
 
 static const char html_endl[] = "\r\n";
 
+//////////////////////////////////////////////////////////////////////
+// Request routes (built in main, before the scheduler runs)
+//////////////////////////////////////////////////////////////////////
+
+enum RouteId {
+	R_Echo = 1,				// Echo the request back
+	R_Stream,				// Streamed response demo
+	R_Hello,				// Greeting by path parameter
+	R_Static				// Files under the document root
+};
+
+static Router routes;
+static StaticFiles *statics = nullptr;		// Created in main
+static SockOptions sockopts;			// Listener and connection tuning
+
+#define ROUTE(id) ((void *)(intptr_t)(id))
+
 //////////////////////////////////////////////////////////////////////
 // HTTP Request Processor
 //////////////////////////////////////////////////////////////////////
 
 static CoroutineBase *
 sock_func(CoroutineBase *co) {
-	static const size_t max_hdrlen = 4096;			// Max length of a header line
+	static const size_t max_echo = 16384;			// Max body bytes echoed back
+	static const size_t max_queued = 64*1024;		// Max rqueue bytes before a flush
+	static const unsigned max_pipelined = 16;		// Max responses in rqueue
 	Service& svc = Service::service(co);			// The invoked Service
 	Scheduler& scheduler = svc.scheduler();			// Invoking scheduler
 	const int sock = svc.socket();				// Socket being processed
 	Events& ev = svc.events();				// EPoll events control
-	std::string reqtype, path, httpvers;
+	Slice reqtype, path, httpvers;
 	HttpBuf hbuf;
-	HttpBuf rhdr, rbody;
+	HttpBuf rbody;
+	Arena& arena = svc.arena();				// Per-request storage
+	Response& resp = svc.response();			// Response header and body fragments
+	char *iobuf = svc.io_buffer();				// Body and stream blocks (Service::io_size)
+	std::string rtext;					// Formatted echo body
+	HttpBuf rqueue;						// Responses queued for pipelined requests
+	std::string rqtext;					// rqueue contents, while being written
+	unsigned n_queued = 0;					// Responses in rqueue
 	std::string body;
-	headermap_t headers;
+	std::size_t body_size = 0;				// Body length as streamed
+	HeaderMap headers(arena);
 	std::size_t content_length = 0;
 	bool keep_alivef = false;				// True when we have Connection: Keep-Alive
-	std::unordered_set<std::string,s_casehash,s_casecmp> transfer_encoding;
-	std::vector<std::map<std::string,std::string,s_caseless>> accept_encoding;
 	bool chunkedf = false;					// True when body is chunked
-	bool gzippedf = false;					// True when body is gzipped
+	bool gzippedf = false;					// True when a compressed coding is accepted
+	Accept accept;						// Negotiated Accept-Encoding
+	Encoding aencoding;					// Preferred coding we can send
+	bool zbodyf = false;					// True when the request body is gzipped
+	BodyInflater inflater;					// Decodes gzipped request bodies
+
+	typedef std::vector<Slice,ArenaAllocator<Slice>> slices_t;
 
 	//////////////////////////////////////////////////////////////
-	// Lookup a header, return std::string
+	// Lookup a header, return Slice
 	//////////////////////////////////////////////////////////////
 
-	auto get_header_str = [&headers](const char *what,std::string& v) -> bool {
-		auto it = headers.find(what);
-		if ( it == headers.end() ) {
-printf("Header '%s' NOT FOUND!\n",what);
+	auto get_header = [&headers](HeaderId what,Slice& v) -> bool {
+		const Slice *pv = headers.find(what);
+		if ( !pv ) {
+printf("Header '%s' NOT FOUND!\n",header_name(what).data);
 			return false;				// Not found
 		}
-		v.assign(it->second);
+		v = *pv;
 		return true;
 	};
 
@@ -60,12 +103,50 @@ printf("Header '%s' NOT FOUND!\n",what);
 	//////////////////////////////////////////////////////////////
 
 	auto exit_coroutine = [&]() {
+		// The stack is not unwound: free what its objects hold
+		inflater.end();				// Stream back to its pool
+		hbuf.release();
+		rbody.release();
+		rqueue.release();
+		std::string().swap(rtext);
+		std::string().swap(rqtext);
+		std::string().swap(body);
 		scheduler.del(sock);			// Remove our socket from Epoll
 		close(sock);				// Close the socket
 		svc.terminate();			// Delete this coroutine
 		assert(0);				// Should never get here..
 	};
 
+	//////////////////////////////////////////////////////////////
+	// Refuse a request body with a simple error response, and
+	// end the connection (the rest of the body is not read).
+	// Responses queued for earlier pipelined requests go first,
+	// in the same write:
+	//////////////////////////////////////////////////////////////
+
+	auto refuse = [&](int status) {
+		struct iovec iov[Response::max_iov+1];
+		int n = 0;
+
+		resp.status(status).date(scheduler.date()).header(H_Connection,"Close").finish();
+		if ( rqueue.tellp() > 0 ) {
+			rqueue.copy(rqtext);
+			iov[n].iov_base = (void *)rqtext.data();
+			iov[n++].iov_len = rqtext.size();
+		}
+		if ( resp.ok() ) {
+			memcpy(iov+n,resp.iovec(),resp.iovcnt() * sizeof iov[0]);
+			n += resp.iovcnt();
+		}
+		try	{
+			scheduler.set_timer(0,svc,60);
+			ev.enable_ev(EPOLLOUT);
+			svc.writev(sock,iov,n);
+		} catch ( Service::Timeout& ) {
+		}
+		exit_coroutine();
+	};
+
 	ev.set_ev(EPOLLIN|EPOLLHUP|EPOLLRDHUP|EPOLLERR);
 
 	//////////////////////////////////////////////////////////////
@@ -73,16 +154,16 @@ printf("Header '%s' NOT FOUND!\n",what);
 	//////////////////////////////////////////////////////////////
 
 	for (;;) {
-		hbuf.reset();
-		rhdr.reset();
 		rbody.reset();
+		resp.reset();
 
-		reqtype.clear();
-		path.clear();
-		httpvers.clear();
 		headers.clear();
+		arena.reset();
 		content_length = 0;
 		keep_alivef = false;
+		chunkedf = false;
+		gzippedf = false;
+		zbodyf = false;
 
 		//////////////////////////////////////////////////////
 		// Read http headers:
@@ -96,102 +177,269 @@ printf("Header '%s' NOT FOUND!\n",what);
 			exit_coroutine();
 		}
 
-		content_length = hbuf.parse_headers(reqtype,path,httpvers,headers,max_hdrlen);
+		content_length = hbuf.parse_headers(arena,reqtype,path,httpvers,headers);
+		if ( content_length == HttpBuf::bad_length )
+			refuse(400);			// Framing we cannot trust (smuggling)
 
 		//////////////////////////////////////////////////////
 		// Check if we have Connection: Keep-Alive
 		//////////////////////////////////////////////////////
 		{
-			std::string keep_alive;
+			Slice keep_alive;
 
-			if ( get_header_str("CONNECTION",keep_alive) )
-				keep_alivef = !strcasecmp(keep_alive.c_str(),"Keep-Alive");
+			if ( get_header(H_Connection,keep_alive) )
+				keep_alivef = keep_alive.iequals("Keep-Alive");
 		}
 
+		accept = scheduler.accept_encoding(headers.find(H_AcceptEncoding));
+		aencoding = accept.choose(Negotiator::supported());
+		gzippedf = aencoding != E_Identity;
+
 		{
-			std::string arg;
+			Slice arg;
+
+			if ( get_header(H_TransferEncoding,arg) ) {
+				slices_t transfer_encoding(arena);
+
+				parse_list(transfer_encoding,arg);
+				for ( const auto& coding : transfer_encoding )
+					if ( coding.iequals("chunked") )
+						chunkedf = true;
+			}
 
-			if ( get_header_str("ACCEPT-ENCODING",arg) ) {
-				parse_fields(accept_encoding,arg.c_str());
-				for ( const auto& map : accept_encoding ) {
-					if ( map.find("gzip") != map.end() ) {
-						gzippedf = true;
+			if ( const Slice *coding = headers.find(H_ContentEncoding) ) {
+				if ( coding->iequals("gzip") || coding->iequals("x-gzip") )
+					zbodyf = true;
+				else if ( !coding->iequals("identity") )
+					refuse(415);		// Unsupported Media Type
+			}
+
+			//////////////////////////////////////////////
+			// Stream the body in bounded pieces, keeping
+			// at most max_echo bytes of it to echo back.
+			// A gzipped body is decompressed as it is
+			// read, within the inflater's limits:
+			//////////////////////////////////////////////
+
+			hbuf.begin_body(content_length,chunkedf);
+			if ( zbodyf )
+				inflater.begin();
+			body.clear();
+			body_size = 0;
+
+			try	{
+				int rc;
+
+				for (;;) {
+					if ( zbodyf )
+						rc = inflater.read(svc,sock,hbuf,iobuf,Service::io_size);
+					else	rc = svc.read_body_chunk(sock,hbuf,iobuf,Service::io_size);
+					if ( rc <= 0 )
 						break;
-					}
-					
+					if ( body.size() < max_echo )
+						body.append(iobuf,std::min(size_t(rc),max_echo - body.size()));
+					body_size += size_t(rc);
 				}
+				if ( rc == -EMSGSIZE )
+					refuse(413);		// Payload Too Large (or a bomb)
+				if ( rc == -EPROTO && zbodyf )
+					refuse(400);		// Corrupt gzip data
+				if ( rc < 0 )
+					exit_coroutine();	// I/O or framing error
+			} catch ( Service::Timeout& e ) {
+				printf("*** TIMEOUT ON TIMER %d BODY ***\n",int(e.timerx));
+				exit_coroutine();
 			}
+			if ( hbuf.have_trailer() )
+				rbody << "Extension headers were present." << html_endl;
 		}
 
-		{
-			std::string arg;
+		Router::Match match;
+		RouteId route = R_Echo;
 
-			if ( get_header_str("TRANSFER-ENCODING",arg) ) {
-				parse_fields(transfer_encoding,arg.c_str());
-				chunkedf = transfer_encoding.find("chunked") != transfer_encoding.end();
-			}
+		if ( routes.match(reqtype,path,match) )
+			route = RouteId(intptr_t(match.handler));
 
-			if ( !chunkedf ) {
-				try	{
-					svc.read_body(sock,hbuf,content_length);
-					body.assign(hbuf.body());
-				} catch ( Service::Timeout& e ) {
-					printf("*** TIMEOUT ON TIMER %d BODY ***\n",int(e.timerx));
-					exit_coroutine();
-				}
-			} else	{
-				std::stringstream unchunked_buf;
-
-				try	{
-					svc.read_chunked(sock,hbuf,unchunked_buf);
-					body.assign(unchunked_buf.str());
-				} catch ( Service::Timeout& e ) {
-					printf("*** TIMEOUT ON TIMER %d CHUNKED BODY ***\n",int(e.timerx));
-					exit_coroutine();
+		//////////////////////////////////////////////////////
+		// Streamed (chunked) response of generated content:
+		//////////////////////////////////////////////////////
+
+		if ( route == R_Stream ) {
+			HttpBuf *bufs[1] = { &rqueue };
+			char *block = iobuf;
+			size_t n = 0;
+
+			hbuf.next();			// Retain pipelined bytes, if any
+
+			resp.status(200)
+				.date(scheduler.date())
+				.header(H_ContentType,"text/plain")
+				.header(H_Connection,keep_alivef ? "Keep-Alive" : "Close");
+
+			try	{
+				scheduler.set_timer(1,svc,10000);
+				svc.write(sock,bufs,1,true);	// Queued pipelined responses
+				rqueue.reset();
+				n_queued = 0;
+				svc.begin_response(sock,resp,-1,
+					gzippedf && Gzip::compressible("text/plain",-1) ? scheduler.compression_level() : 0,aencoding);
+				for ( int x=1; x <= 100000; ++x ) {
+					n += snprintf(block+n,Service::io_size-n,"Line %d%s",x,html_endl);
+					if ( n + 64 > Service::io_size ) {
+						svc.write_body(sock,block,n);
+						n = 0;
+					}
 				}
-				if ( hbuf.parse_xheaders(headers,max_hdrlen) )
-					rbody << "Extension headers were present." << html_endl;
+				svc.write_body(sock,block,n);
+				svc.end_response(sock);
+			} catch ( Service::Timeout& e ) {
+				printf("*** TIMEOUT ON TIMER %d STREAM ***\n",int(e.timerx));
+				exit_coroutine();
 			}
+
+			if ( !keep_alivef || (svc.err_flags() & (EPOLLHUP|EPOLLRDHUP|EPOLLERR)) )
+				break;
+			continue;
 		}
 
 		//////////////////////////////////////////////////////
-		// Form Reponse:
+		// Static files, sent with sendfile(2):
 		//////////////////////////////////////////////////////
 
-		rhdr	<< "HTTP/1.1 200 OK " << html_endl;
-	
-		if ( keep_alivef )
-			rhdr << "Connection: Keep-Alive" << html_endl;
-		else	rhdr << "Connection: Close" << html_endl;
+		if ( route == R_Static ) {
+			HttpBuf *bufs[1] = { &rqueue };
+			Slice file = Query::decode(arena,*match.param("file"),false);
+			int rc = -1;
 
-		rbody	<< "Request type: " << reqtype << html_endl
-			<< "Request path: " << path << html_endl
-			<< "Http Version: " << httpvers << html_endl
-			<< "Request Headers were:" << html_endl
-			<< "Gzipped: " << gzippedf << html_endl;
+			hbuf.next();			// Retain pipelined bytes, if any
 
-		for ( auto& pair : headers ) {
-			const std::string& hdr = pair.first;
-			const std::string& val = pair.second;
+			ev.disable_ev(EPOLLIN);
+			ev.enable_ev(EPOLLOUT);
 
-			rbody	<< "Hdr: " << hdr << ": " << val << html_endl;
+			try	{
+				scheduler.set_timer(1,svc,10000);
+				if ( rqueue.tellp() > 0 ) {
+					svc.write(sock,bufs,1,true);	// Queued pipelined responses
+					rqueue.reset();
+					n_queued = 0;
+				}
+				rc = statics->serve(svc,sock,reqtype,file,headers,resp,scheduler.date(),keep_alivef);
+			} catch ( Service::Timeout& e ) {
+				printf("*** TIMEOUT ON TIMER %d STATIC ***\n",int(e.timerx));
+				exit_coroutine();
+			}
+
+			ev.disable_ev(EPOLLOUT);
+			ev.enable_ev(EPOLLIN);
+
+			if ( rc < 0 || !keep_alivef || (svc.err_flags() & (EPOLLHUP|EPOLLRDHUP|EPOLLERR)) )
+				break;
+			continue;
+		}
+
+		ResponseCache::EntryPtr cached;			// Held while being sent
+		struct iovec civ[ResponseCache::max_iov];
+		struct iovec *riov;				// Response to send
+		int riovcnt;
+		const bool headf = Router::method(reqtype) == Router::M_HEAD;
+
+		if ( route == R_Hello ) {
+			//////////////////////////////////////////////
+			// Cacheable response: a hit skips the handler.
+			// HEAD shares the GET entry (it routes to the
+			// GET handler), and sends only its headers:
+			//////////////////////////////////////////////
+			ResponseCache& rcache = scheduler.response_cache();
+			const Slice method = headf ? Slice("GET",3) : reqtype;
+			time_t now = ::time(nullptr);
+
+			cached = rcache.lookup(method,path,now);
+			if ( !cached ) {
+				Slice name = Query::decode(arena,*match.param("name"),false);
+
+				rtext.assign("Hello, ").append(name.data,name.size).append("!").append(html_endl);
+				cached = rcache.insert(method,path,200,"text/plain; charset=utf-8",Slice(rtext.data(),rtext.size()),now,
+					0,std::max(scheduler.compression_level(),1));
+			}
+			riovcnt = ResponseCache::gather(*cached,accept,scheduler.date(),keep_alivef,civ);
+			if ( headf )
+				--riovcnt;			// The body is the last fragment
+			riov = civ;
+		} else	{
+			//////////////////////////////////////////////////////
+			// Form Reponse:
+			//////////////////////////////////////////////////////
+
+			resp.status(200)
+				.date(scheduler.date())
+				.header(H_Connection,keep_alivef ? "Keep-Alive" : "Close");
+
+			rbody	<< "Request type: " << reqtype << html_endl
+				<< "Request path: " << path << html_endl
+				<< "Http Version: " << httpvers << html_endl
+				<< "Request Headers were:" << html_endl
+				<< "Gzipped: " << gzippedf << html_endl;
+
+			for ( auto& hdr : headers )
+				rbody	<< "Hdr: " << hdr.name << ": " << hdr.value << html_endl;
+
+			{
+				Slice rpath, query, key, value;
+
+				Query::split(path,rpath,query);
+				for ( QueryIter it(query); it.next(key,value); )
+					rbody	<< "Query: " << Query::decode(arena,key) << " = "
+						<< Query::decode(arena,value) << html_endl;
+			}
+
+			rbody 	<< "Socket fd = " << sock << html_endl
+				<< "Extracted body was " << body_size << " bytes in length" << html_endl
+				<< "Body was {" << html_endl
+				<< body << html_endl
+				<< '}' << html_endl;
+
+			rbody.copy(rtext);
+			resp.body(rtext.data(),rtext.size()).finish();
+			riov = resp.iovec();
+			riovcnt = headf ? 1 : resp.iovcnt();	// iov[0] is the header
 		}
 
-		rbody 	<< "Socket fd = " << sock << html_endl
-			<< "Extracted body was " << body.size() << " bytes in length" << html_endl
-			<< "Body was {" << html_endl
-			<< body << html_endl
-			<< '}' << html_endl;
+		//////////////////////////////////////////////////////
+		// When the next pipelined request is already buffered,
+		// queue this response and flush the batch later with
+		// one write. The queue is flushed at max_queued bytes
+		// or max_pipelined responses regardless, so a client
+		// that pipelines without reading meets backpressure:
+		//////////////////////////////////////////////////////
 
-		rhdr	<< "Content-Length: " << rbody.tellp() << html_endl << html_endl;
+		hbuf.next();				// Retain pipelined bytes, if any
+
+		if ( keep_alivef && n_queued + 1 < max_pipelined && size_t(rqueue.tellp()) < max_queued
+		  && hbuf.have_end(nullptr,nullptr) ) {
+			for ( int x=0; x<riovcnt; ++x )
+				rqueue << Slice((const char *)riov[x].iov_base,riov[x].iov_len);
+			++n_queued;
+			continue;
+		}
 
 		ev.disable_ev(EPOLLIN);
 		ev.enable_ev(EPOLLOUT);
 
 		try	{
 			scheduler.set_timer(0,svc,60);
-			svc.write(sock,rhdr);
-			svc.write(sock,rbody);
+			if ( rqueue.tellp() > 0 ) {
+				struct iovec iov[Response::max_iov+1];
+
+				rqueue.copy(rqtext);
+				iov[0].iov_base = (void *)rqtext.data();
+				iov[0].iov_len = rqtext.size();
+				memcpy(iov+1,riov,riovcnt * sizeof iov[0]);
+				svc.writev(sock,iov,riovcnt+1);
+				rqueue.reset();
+				n_queued = 0;
+			} else	{
+				svc.writev(sock,riov,riovcnt);
+			}
 		} catch ( Service::Timeout& e ) {
 			printf("*** TIMEOUT ON TIMER %d OUTPUT ***\n",int(e.timerx));
 			exit_coroutine();
@@ -213,51 +461,77 @@ printf("Header '%s' NOT FOUND!\n",what);
 }
 
 //////////////////////////////////////////////////////////////////////
-// Listen coroutine
+// UDP Echo: each datagram is sent back to its sender
 //////////////////////////////////////////////////////////////////////
 
-static CoroutineBase *
-listen_func(CoroutineBase *co) {
-	Service& listen_co = *(Service*)co;
-	Scheduler& scheduler = *dynamic_cast<Scheduler*>(listen_co.get_caller());
-	u_address addr;
-	socklen_t addrlen = sizeof addr;
-	int lsock = listen_co.socket();
-	int fd;
+static void
+udp_echo(DgramService& svc,const DgramService::Datagram& dgram,void *arg) {
 
-	for (;;) {
-		fd = ::accept4(lsock,&addr.addr,&addrlen,SOCK_NONBLOCK);
-		if ( fd < 0 ) {
-			listen_co.yield();	// Yield to Epoll
-		} else	{
-			Service *svc = new Service(sock_func,fd);
-			scheduler.add(fd,EPOLLIN|EPOLLHUP|EPOLLRDHUP|EPOLLERR,svc);
-scheduler.set_timer(0u,*svc,1);
-		}
-	}
-
-	return nullptr;
+	if ( !dgram.truncated )
+		svc.reply(dgram,dgram.data,dgram.size);
 }
 
 int
 main(int argc,char **argv) {
 	Scheduler scheduler;
 	int port = 2345, backlog = 50;
+	unsigned accept_budget = Acceptor::default_budget;	// Connections accepted per wakeup
+	bool udp_echof = false;					// UDP echo on the listen port(s)
 
 	scheduler.add_timer(2,10);
 	scheduler.add_timer(10,1000);
 
+	routes.add("GET","/stream",ROUTE(R_Stream));
+	routes.add("GET","/hello/:name",ROUTE(R_Hello));
+	routes.add("GET","/static/*file",ROUTE(R_Static));
+	routes.add("HEAD","/static/*file",ROUTE(R_Static));
+	routes.add("*","/*path",ROUTE(R_Echo));
+	routes.compile();
+
+	{
+		const char *docroot = getenv("DOCROOT");
+
+		statics = new StaticFiles(docroot ? docroot : ".");
+		if ( !statics->ok() )
+			fprintf(stderr,"Warning: document root %s: %s\n",
+				docroot ? docroot : ".",strerror(errno));
+	}
+
+	if ( const char *budget = getenv("ACCEPT_BUDGET") )
+		accept_budget = unsigned(strtoul(budget,nullptr,10));
+
+	// Opt-in: an open UDP echo can reflect spoofed traffic
+	if ( const char *echo = getenv("UDP_ECHO") )
+		udp_echof = atoi(echo) != 0;
+
+	sockopts.nodelay = true;		// Responses are written whole (gather writes)
+	sockopts.defer_accept = 5;		// Wake on the request, not the handshake
+	sockopts.notsent_lowat = 16*1024;	// Bound unsent data queued in the kernel
+
 	auto add_listen_port = [&](const char *straddr) {
 		u_address addr;
 		int lfd = -1;
 		bool bf;
 
-		Sockets::import_ip(straddr,addr);
-		lfd = Sockets::listen(addr,port,backlog);
+		if ( !Sockets::import_address(straddr,addr) ) {	// IP, /path or @abstract
+			fprintf(stderr,"Invalid listen address: %s\n",straddr);
+			exit(2);
+		}
+		lfd = Sockets::listen(addr,port,backlog,sockopts);
 		assert(lfd >= 0);
 
-		Service *svc = new Service(listen_func,lfd);
-		bf = scheduler.add(lfd,EPOLLIN,svc);
+		Acceptor *acc = new Acceptor(lfd,sock_func,sockopts,accept_budget);
+		bf = acc->start(scheduler);
+		assert(bf);
+
+		if ( !udp_echof || addr.addr.sa_family == AF_UNIX )
+			return;
+
+		int ufd = Sockets::bind_dgram(addr,port,sockopts);	// UDP echo, same port
+		assert(ufd >= 0);
+
+		DgramService *dgs = new DgramService(ufd,udp_echo);
+		bf = dgs->start(scheduler);
 		assert(bf);
 	};
 
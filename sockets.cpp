@@ -10,6 +10,10 @@
 #include <errno.h>
 #include <string.h>
 #include <assert.h>
+#include <netinet/tcp.h>
+#include <linux/filter.h>
+#include <sys/stat.h>
+#include <stddef.h>
 
 #include "sockets.hpp"
 
@@ -22,6 +26,65 @@ Sockets::import_ip(const char *straddr,u_address& addr) {
         else    return import_ipv6(straddr,addr);
 }
 
+//////////////////////////////////////////////////////////////////////
+// Import a unix domain socket address: a path name, or an abstract
+// socket name when it starts with '@' (Linux: no file is created).
+//////////////////////////////////////////////////////////////////////
+
+bool
+Sockets::import_unix(const char *path,u_address& addr) {
+	size_t len = strlen(path);
+
+	memset(&addr.addrun,0,sizeof addr.addrun);
+	if ( len == 0 || len >= sizeof addr.addrun.sun_path || (len == 1 && *path == '@') )
+		return false;				// Empty or too long
+	memcpy(addr.addrun.sun_path,path,len);
+	if ( *path == '@' )
+		addr.addrun.sun_path[0] = 0;		// Abstract namespace
+	addr.addrun.sun_family = AF_UNIX;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Import a listening address: a unix socket when it starts with '/',
+// '.' or '@', else an IPv4 or IPv6 address.
+//////////////////////////////////////////////////////////////////////
+
+bool
+Sockets::import_address(const char *straddr,u_address& addr) {
+
+	if ( *straddr == '/' || *straddr == '.' || *straddr == '@' )
+		return import_unix(straddr,addr);
+	return import_ip(straddr,addr);
+}
+
+//////////////////////////////////////////////////////////////////////
+// The length of an address for bind(2) and connect(2). An abstract
+// unix name is counted up to its first NUL (after the leading NUL).
+//////////////////////////////////////////////////////////////////////
+
+socklen_t
+Sockets::address_len(const u_address& addr) noexcept {
+
+	switch ( addr.addr.sa_family ) {
+	case AF_INET:
+		return sizeof addr.addr4;
+	case AF_INET6:
+		return sizeof addr.addr6;
+	case AF_UNIX:
+		{
+			const char *path = addr.addrun.sun_path;
+			size_t max = sizeof addr.addrun.sun_path;
+
+			if ( !*path )		// Abstract
+				return socklen_t(offsetof(sockaddr_un,sun_path) + 1 + strnlen(path+1,max-1));
+			return socklen_t(offsetof(sockaddr_un,sun_path) + strnlen(path,max) + 1);
+		}
+	default:
+		return sizeof addr;
+	}
+}
+
 bool
 Sockets::import_ipv4(const char *ipv4,u_address& addr) {
 
@@ -56,6 +119,146 @@ Sockets::import_ipv6(const char *ipv6,u_address& addr) {
 
 int
 Sockets::listen(u_address& address,int port,unsigned backlog,bool reuse_port) {
+	SockOptions opts;
+
+	opts.reuse_port = reuse_port;
+	return listen(address,port,backlog,opts);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set the tuning options on a socket. For a listening socket, all of
+// them (before bind(2) and listen(2), so that SO_RCVBUF can affect
+// window scaling), else only those that apply to a connection.
+//
+// RETURNS:
+//	0	Success
+//	-1	setsockopt(2) failed, see errno
+//////////////////////////////////////////////////////////////////////
+
+int
+Sockets::configure(int sock,const SockOptions& opts,bool listener) {
+	static const int one = 1;
+	int domain = AF_INET, type = SOCK_STREAM;
+	socklen_t len = sizeof domain;
+
+	auto set = [sock](int level,int name,int value) -> bool {
+		return setsockopt(sock,level,name,&value,sizeof value) == 0;
+	};
+
+	if ( opts.rcvbuf > 0 && !set(SOL_SOCKET,SO_RCVBUF,opts.rcvbuf) )
+		return -1;
+	if ( opts.sndbuf > 0 && !set(SOL_SOCKET,SO_SNDBUF,opts.sndbuf) )
+		return -1;
+
+	getsockopt(sock,SOL_SOCKET,SO_DOMAIN,&domain,&len);
+	if ( domain == AF_UNIX )
+		return 0;			// The rest are TCP/IP options
+	len = sizeof type;
+	getsockopt(sock,SOL_SOCKET,SO_TYPE,&type,&len);
+
+	const bool tcp = type == SOCK_STREAM;	// Else UDP: no TCP options
+
+	if ( tcp && opts.nodelay && !set(IPPROTO_TCP,TCP_NODELAY,one) )
+		return -1;
+#ifdef TCP_NOTSENT_LOWAT
+	if ( tcp && opts.notsent_lowat > 0 && !set(IPPROTO_TCP,TCP_NOTSENT_LOWAT,opts.notsent_lowat) )
+		return -1;
+#endif
+#ifdef SO_BUSY_POLL
+	if ( opts.busy_poll > 0 && !set(SOL_SOCKET,SO_BUSY_POLL,opts.busy_poll) )
+		return -1;
+#endif
+
+	if ( !listener )
+		return 0;
+
+#ifdef SO_REUSEPORT
+	if ( opts.reuse_port && !set(SOL_SOCKET,SO_REUSEPORT,one) )
+		return -1;
+#endif
+#ifdef TCP_DEFER_ACCEPT
+	if ( tcp && opts.defer_accept > 0 && !set(IPPROTO_TCP,TCP_DEFER_ACCEPT,opts.defer_accept) )
+		return -1;
+#endif
+#ifdef TCP_FASTOPEN
+	if ( tcp && opts.fastopen > 0 && !set(IPPROTO_TCP,TCP_FASTOPEN,opts.fastopen) )
+		return -1;
+#endif
+#ifdef SO_INCOMING_CPU
+	if ( opts.incoming_cpu >= 0 && !set(SOL_SOCKET,SO_INCOMING_CPU,opts.incoming_cpu) )
+		return -1;
+#endif
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Apply the connection options to a socket returned by accept4(2),
+// unless it inherited them from the listening socket:
+//////////////////////////////////////////////////////////////////////
+
+int
+Sockets::accepted(int sock,const SockOptions& opts) {
+
+	if ( !opts.reapply )
+		return 0;
+	return configure(sock,opts,false);
+}
+
+//////////////////////////////////////////////////////////////////////
+// True when the unix socket file at address has no listener: a
+// connect(2) to it is refused. A live socket (accepting, or with a
+// full backlog) is not stale.
+//////////////////////////////////////////////////////////////////////
+
+static bool
+stale_unix(const u_address& address) {
+	int sock = ::socket(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+	bool stale;
+
+	if ( sock == -1 )
+		return false;
+	stale = ::connect(sock,&address.addr,Sockets::address_len(address)) == -1 && errno == ECONNREFUSED;
+	::close(sock);
+	return stale;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Steer connections within a SO_REUSEPORT group to the socket of the
+// CPU that received them: a classic BPF program returns the index
+// cpu % n_sockets. Sockets are indexed in the order they were bound,
+// so the listener of the Scheduler pinned to CPU x must be bound x'th.
+// The program applies to the whole group, and needs no privileges.
+//
+// RETURNS:
+//	0	Success
+//	-1	Failed, see errno (ENOPROTOOPT: not supported)
+//////////////////////////////////////////////////////////////////////
+
+int
+Sockets::steer_by_cpu(int sock,unsigned n_sockets) {
+#if defined(SO_ATTACH_REUSEPORT_CBPF) && defined(SKF_AD_CPU)
+	struct sock_filter code[] = {
+		{ BPF_LD | BPF_W | BPF_ABS, 0, 0, uint32_t(SKF_AD_OFF + SKF_AD_CPU) },	// A = cpu
+		{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, n_sockets },				// A %= n
+		{ BPF_RET | BPF_A, 0, 0, 0 },						// Socket index A
+	};
+	struct sock_fprog prog = { sizeof code / sizeof code[0], code };
+
+	if ( !n_sockets ) {
+		errno = EINVAL;
+		return -1;
+	}
+	return setsockopt(sock,SOL_SOCKET,SO_ATTACH_REUSEPORT_CBPF,&prog,sizeof prog);
+#else
+	(void)sock;
+	(void)n_sockets;
+	errno = ENOPROTOOPT;
+	return -1;
+#endif
+}
+
+int
+Sockets::listen(u_address& address,int port,unsigned backlog,const SockOptions& opts) {
         static const int one = 1;
 	int sock, af = address.addr4.sin_family;
 	int rc;
@@ -63,21 +266,11 @@ Sockets::listen(u_address& address,int port,unsigned backlog,bool reuse_port) {
         if ( (sock = socket(af,SOCK_STREAM|SOCK_NONBLOCK,0)) == -1 )
                 return -1;              // Socket failure, see errno
 
-	rc = setsockopt(sock,SOL_SOCKET,SO_REUSEADDR,(char *)&one,sizeof one);
-	if ( rc == -1 ) {
+	rc = af == AF_UNIX ? 0 : setsockopt(sock,SOL_SOCKET,SO_REUSEADDR,(char *)&one,sizeof one);
+	if ( rc == -1 || configure(sock,opts,true) == -1 ) {
 		::close(sock);
 		return -2;      // Set sock opt failure:
         }
-
-#ifdef SO_REUSEPORT
-        if ( reuse_port ) {
-		rc = setsockopt(sock,SOL_SOCKET,SO_REUSEPORT,(char *)&one,sizeof one);
-                if ( rc == -1 ) {  
-			::close(sock);
-			return -2;      // Set sock opt failure:
-		}
-	}
-#endif
         
         switch ( af ) {
         case AF_INET:
@@ -103,6 +296,23 @@ Sockets::listen(u_address& address,int port,unsigned backlog,bool reuse_port) {
                                 return -3;              // bind failure
                         }
                 }
+                break;
+	case AF_UNIX:
+		{
+			const char *path = address.addrun.sun_path;
+			struct stat st;
+
+			// Replace a stale socket file (port is not used), but
+			// not one that a running server is listening on
+			if ( *path && ::lstat(path,&st) == 0 && S_ISSOCK(st.st_mode) && stale_unix(address) )
+				::unlink(path);
+			rc = ::bind(sock,&address.addr,address_len(address));
+			if ( rc == -1 ) {
+				::close(sock);
+				return -3;		// bind failure
+			}
+		}
+		break;
         }
         
         rc = ::listen(sock,backlog);
@@ -110,9 +320,60 @@ Sockets::listen(u_address& address,int port,unsigned backlog,bool reuse_port) {
                 ::close(sock);
                 return -4;              // listen(2) failure
         }
+
+	// After listen(2): when attached earlier, later members of the group
+	// fail listen(2) with EADDRINUSE
+	if ( af != AF_UNIX && opts.reuse_port && opts.steer_cpus > 0 && steer_by_cpu(sock,opts.steer_cpus) == -1 ) {
+		::close(sock);
+		return -2;	// Set sock opt failure
+	}
 	
 	return sock;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Create a non-blocking UDP socket bound to address and port, with
+// the options (reuse_port for SO_REUSEPORT fan-out across sockets,
+// steer_cpus, buffer sizes ..).
+//
+// RETURNS:
+//	>= 0	The socket
+//	-1	socket(2) failure, see errno
+//	-2	setsockopt(2) failure
+//	-3	bind(2) failure
+//////////////////////////////////////////////////////////////////////
+
+int
+Sockets::bind_dgram(u_address& address,int port,const SockOptions& opts) {
+	int sock, af = address.addr.sa_family;
+
+	if ( af != AF_INET && af != AF_INET6 ) {
+		errno = EAFNOSUPPORT;
+		return -1;
+	}
+	if ( (sock = socket(af,SOCK_DGRAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0)) == -1 )
+		return -1;
+
+	if ( configure(sock,opts,true) == -1 ) {
+		::close(sock);
+		return -2;
+	}
+
+	if ( af == AF_INET )
+		address.addr4.sin_port = htons(port);
+	else	address.addr6.sin6_port = htons(port);
+
+	if ( ::bind(sock,&address.addr,address_len(address)) == -1 ) {
+		::close(sock);
+		return -3;
+	}
+
+	if ( opts.reuse_port && opts.steer_cpus > 0 && steer_by_cpu(sock,opts.steer_cpus) == -1 ) {
+		::close(sock);
+		return -2;
+	}
+	return sock;
+}
+
 // End sockets.cpp
 
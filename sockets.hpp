@@ -10,18 +10,51 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <net/if.h>
+#include <sys/un.h>
 
 union u_address {
 	struct sockaddr		addr;
 	struct sockaddr_in 	addr4;		// AF_INET
 	struct sockaddr_in6	addr6;		// AF_INET6
+	struct sockaddr_un	addrun;		// AF_UNIX
+};
+
+//////////////////////////////////////////////////////////////////////
+// Socket tuning options. A zero (or -1 for incoming_cpu) leaves the
+// system default. They are set on the listening socket, and Linux
+// accepted sockets inherit them from it; set reapply to also set the
+// per-connection options on each accepted socket (see accepted()).
+// Only SO_RCVBUF and SO_SNDBUF apply to AF_UNIX sockets, and the TCP
+// options do not apply to UDP sockets (see bind_dgram()).
+//////////////////////////////////////////////////////////////////////
+
+struct SockOptions {
+	bool		reuse_port = false;	// SO_REUSEPORT
+	bool		nodelay = false;	// TCP_NODELAY
+	int		defer_accept = 0;	// TCP_DEFER_ACCEPT: seconds to wait for data
+	int		fastopen = 0;		// TCP_FASTOPEN: pending TFO request queue length
+	int		rcvbuf = 0;		// SO_RCVBUF bytes
+	int		sndbuf = 0;		// SO_SNDBUF bytes
+	int		notsent_lowat = 0;	// TCP_NOTSENT_LOWAT bytes
+	int		busy_poll = 0;		// SO_BUSY_POLL microseconds
+	int		incoming_cpu = -1;	// SO_INCOMING_CPU
+	unsigned	steer_cpus = 0;		// SO_ATTACH_REUSEPORT_CBPF: steer by CPU (see steer_by_cpu())
+	bool		reapply = false;	// accepted() sets connection options
 };
 
 namespace Sockets {
 	bool import_ip(const char *straddr,u_address& addr);
 	bool import_ipv4(const char *ipv4,u_address& addr);
 	bool import_ipv6(const char *ipv6,u_address& addr);
+	bool import_unix(const char *path,u_address& addr);
+	bool import_address(const char *straddr,u_address& addr);
+	socklen_t address_len(const u_address& addr) noexcept;
 	int listen(u_address& address,int port,unsigned backlog,bool reuse_port=false);
+	int listen(u_address& address,int port,unsigned backlog,const SockOptions& opts);
+	int configure(int sock,const SockOptions& opts,bool listener);
+	int accepted(int sock,const SockOptions& opts);
+	int steer_by_cpu(int sock,unsigned n_sockets);
+	int bind_dgram(u_address& address,int port,const SockOptions& opts);
 }
 
 #endif // SOCKETS_HPP
@@ -35,4 +35,56 @@ ucase_buffer(char *buf) {
 			*buf &= ~0x20;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Format an unsigned integer in decimal, two digits at a time. The
+// buffer must have room for 20 bytes; no NUL is appended.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+fmt_uint(char *buf,uint64_t v) noexcept {
+	static const char pairs[] =
+		"00010203040506070809101112131415161718192021222324"
+		"25262728293031323334353637383940414243444546474849"
+		"50515253545556575859606162636465666768697071727374"
+		"75767778798081828384858687888990919293949596979899";
+	char tmp[20];
+	char *p = tmp + sizeof tmp;
+	size_t n;
+
+	while ( v >= 100 ) {
+		unsigned x = unsigned(v % 100) * 2;
+
+		v /= 100;
+		p -= 2;
+		p[0] = pairs[x];
+		p[1] = pairs[x+1];
+	}
+	if ( v >= 10 ) {
+		p -= 2;
+		p[0] = pairs[v*2];
+		p[1] = pairs[v*2+1];
+	} else	*--p = char('0' + v);
+
+	n = size_t(tmp + sizeof tmp - p);
+	memcpy(buf,p,n);
+	return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Format an unsigned integer in lowercase hex (chunk sizes). The
+// buffer must have room for 16 bytes; no NUL is appended.
+//////////////////////////////////////////////////////////////////////
+
+size_t
+fmt_hex(char *buf,uint64_t v) noexcept {
+	static const char digits[] = "0123456789abcdef";
+	size_t n = 1;
+
+	for ( uint64_t t = v >> 4; t; t >>= 4 )
+		++n;
+	for ( size_t x = n; x-- > 0; v >>= 4 )
+		buf[x] = digits[v & 0x0F];
+	return n;
+}
+
 // End utility.cpp
@@ -6,13 +6,23 @@
 #ifndef UTILITY_HPP
 #define UTILITY_HPP
 
+#include <stdint.h>
 #include <time.h>
 #include <string.h>
+#include <strings.h>
 #include <string>
+#include <ostream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 void ucase_buffer(char *buf);
 timespec& timeofday(timespec &tod);
 
+size_t fmt_uint(char *buf,uint64_t v) noexcept;		// Decimal, no NUL: returns length (<= 20)
+size_t fmt_hex(char *buf,uint64_t v) noexcept;		// Lowercase hex, no NUL: returns length (<= 16)
+
 inline
 bool operator==(const timespec& a,const timespec &b) noexcept {
 	return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
@@ -78,26 +88,110 @@ long millisecs(const timespec &tspec) {
 	return tspec.tv_sec * 1000L + tspec.tv_nsec / 1000000L;
 }
 
+//////////////////////////////////////////////////////////////////////
+// Slice: A non-owning reference to size bytes at data
+//////////////////////////////////////////////////////////////////////
+
+struct Slice {
+	const char	*data=nullptr;
+	size_t		size=0;
+
+	Slice() {}
+	Slice(const char *data,size_t size) : data(data), size(size) {}
+	Slice(const char *cstr) : data(cstr), size(strlen(cstr)) {}
+
+	bool empty() const noexcept			{ return !size; }
+	std::string str() const				{ return std::string(data,size); }
+	const char *begin() const noexcept		{ return data; }
+	const char *end() const noexcept		{ return data + size; }
+
+	bool equals(const char *s,size_t n) const noexcept	{ return size == n && !memcmp(data,s,n); }
+	bool equals(const char *s) const noexcept		{ return equals(s,strlen(s)); }
+	bool iequals(const char *s,size_t n) const noexcept	{ return size == n && !strncasecmp(data,s,n); }
+	bool iequals(const char *s) const noexcept		{ return iequals(s,strlen(s)); }
+	bool starts_with(const char *s) const noexcept {
+		size_t n = strlen(s);
+		return size >= n && !memcmp(data,s,n);
+	}
+};
+
+inline
+std::ostream& operator<<(std::ostream& os,const Slice& slice) {
+	return os.write(slice.data,slice.size);
+}
+
+//////////////////////////////////////////////////////////////////////
+// Case insensitive hashing: ASCII letters are folded to lowercase
+// eight at a time (sixteen with SSE2), and mixed a word at a time.
+// Both paths produce the same hash value.
+//////////////////////////////////////////////////////////////////////
+
+inline uint64_t
+fold_word(uint64_t w) noexcept {
+	static const uint64_t ones = 0x0101010101010101ull;
+	uint64_t b7 = w & (0x7F * ones);			// Bytes without their high bit
+	uint64_t ge_A = b7 + (0x80 - 'A') * ones;		// High bit set when >= 'A'
+	uint64_t gt_Z = b7 + (0x80 - 'Z' - 1) * ones;		// High bit set when > 'Z'
+
+	return w | (((ge_A ^ gt_Z) & ~w & (0x80 * ones)) >> 2);	// 0x20 for 'A'..'Z'
+}
+
+inline uint64_t
+mix_word(uint64_t h,uint64_t w) noexcept {
+	w *= 0x87C37B91114253D5ull;
+	w = (w << 31) | (w >> 33);
+	h ^= w * 0x4CF5AD432745937Full;
+	return ((h << 27) | (h >> 37)) * 5 + 0x52DCE729;
+}
+
+inline uint64_t
+casehash(const char *data,size_t len,uint64_t seed=0) noexcept {
+	const char *p = data, *e = data + len;
+	uint64_t h = seed ^ (uint64_t(len) * 0x9E3779B97F4A7C15ull);
+	uint64_t w;
+
+#ifdef __SSE2__
+	const __m128i a1 = _mm_set1_epi8('A' - 1), z1 = _mm_set1_epi8('Z' + 1);
+	const __m128i bit = _mm_set1_epi8(0x20);
+	uint64_t ws[2];
+
+	for ( ; e - p >= 16; p += 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v,a1),_mm_cmplt_epi8(v,z1));
+
+		v = _mm_or_si128(v,_mm_and_si128(upper,bit));
+		_mm_storeu_si128((__m128i *)ws,v);
+		h = mix_word(mix_word(h,ws[0]),ws[1]);
+	}
+#endif
+	for ( ; e - p >= 8; p += 8 ) {
+		memcpy(&w,p,8);
+		h = mix_word(h,fold_word(w));
+	}
+	if ( p < e ) {
+		w = 0;
+		memcpy(&w,p,size_t(e - p));
+		h = mix_word(h,fold_word(w));
+	}
+
+	// Final avalanche:
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+	return h;
+}
+
 struct s_casehash {
 	inline size_t operator()(const std::string& key) const noexcept {
-		unsigned sz = unsigned(key.size());
-		const char *keyp = key.c_str();
-		char ch;
-		size_t h = 0;
-
-		while ( sz-- > 0 ) {
-			ch = *keyp++;
-			if ( ch >= 'a' && ch <= 'z' )
-				ch ^= 0x20;
-			h += size_t(ch);
-		}
-		return h;
+		return size_t(casehash(key.data(),key.size()));
 	}
 };
 
 struct s_casecmp {
 	inline bool operator()(const std::string& left,const std::string& right) const noexcept {
-		return !strcasecmp(left.c_str(),right.c_str());
+		return left.size() == right.size() && !strncasecmp(left.data(),right.data(),left.size());
 	}
 };
 
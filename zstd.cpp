@@ -0,0 +1,309 @@
+//////////////////////////////////////////////////////////////////////
+// zstd.cpp -- Zstandard compression
+// Date: Mon Oct 19 19:41:27 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+
+#include "zstd.hpp"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+static const size_t out_threshold = 32;	// Write callback when less space remains
+static const int max_window_log = 23;	// Decoder window limit (8 MiB)
+
+Zstd::Zstd(Mode mode,size_t outbufsize,write_cb_t write_cb,int level)
+  : mode(mode), outsize(outbufsize), level(level), write_cb(write_cb) {
+
+	outbuf = new unsigned char[outsize];
+#ifdef HAVE_ZSTD
+	if ( mode == Compress ) {
+		cctx = ZSTD_createCCtx();
+		ZSTD_CCtx_setParameter(cctx,ZSTD_c_compressionLevel,level);
+	} else	{
+		dctx = ZSTD_createDCtx();
+		ZSTD_DCtx_setParameter(dctx,ZSTD_d_windowLogMax,max_window_log);
+	}
+#endif
+}
+
+Zstd::~Zstd() {
+#ifdef HAVE_ZSTD
+	ZSTD_freeCCtx(cctx);
+	ZSTD_freeDCtx(dctx);
+#endif
+	delete []outbuf;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Map a zlib level (1..9) to a zstd level of similar CPU cost. zstd
+// levels 1-3 compress better than zlib level 1, and faster.
+//////////////////////////////////////////////////////////////////////
+
+int
+Zstd::level_for(int zlib_level) noexcept {
+	static const int levels[10] = { 0, 1, 2, 2, 3, 3, 3, 5, 6, 9 };
+
+	if ( zlib_level <= 0 )
+		return 0;
+	return levels[zlib_level > 9 ? 9 : zlib_level];
+}
+
+void
+Zstd::write_callback(void *arg) {
+
+	if ( outpos > 0 ) {
+		write_cb((void *)outbuf,outpos,arg);
+		out_total += outpos;
+		outpos = 0;
+	}
+}
+
+#ifdef HAVE_ZSTD
+
+const bool Zstd::available = true;
+
+static int
+zstd_error(size_t rc,int def) noexcept {
+	return ZSTD_getErrorCode(rc) == ZSTD_error_memory_allocation ? Z_MEM_ERROR : def;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Complete the compressed frame, writing all of its output:
+//////////////////////////////////////////////////////////////////////
+
+int
+Zstd::end_frame(void *arg) {
+	ZSTD_inBuffer in = { nullptr, 0, 0 };
+	ZSTD_outBuffer out;
+	size_t rc;
+
+	do	{
+		out = { outbuf, outsize, outpos };
+		rc = ZSTD_compressStream2(cctx,&out,&in,ZSTD_e_end);
+		if ( ZSTD_isError(rc) )
+			return zstd_error(rc,Z_STREAM_ERROR);
+		outpos = out.pos;
+		if ( outsize - outpos <= out_threshold || rc == 0 ) {
+			write_callback(arg);
+			if ( abortf )
+				return Aborted;
+		}
+	} while ( rc != 0 );
+	return Z_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+// compress(), decompress() and finish() return as for Zlib:
+//
+//	Z_OK		Success
+//	Z_STREAM_END	decompress(): the end of the frame was reached.
+//			Input following it is ignored.
+//	Aborted		abort() was called by the write callback
+//	< 0		Error: Z_DATA_ERROR for corrupt or truncated input,
+//			Z_MEM_ERROR, or Z_STREAM_ERROR for misuse
+//////////////////////////////////////////////////////////////////////
+
+int
+Zstd::compress(void *buf,size_t bytes,void *arg) {
+	ZSTD_inBuffer in = { buf, bytes, 0 };
+	ZSTD_outBuffer out;
+	size_t rc;
+	bool filled;
+
+	if ( mode != Compress || !cctx || frame == 2 )
+		return Z_STREAM_ERROR;
+	frame = 1;
+
+	do	{
+		out = { outbuf, outsize, outpos };
+		rc = ZSTD_compressStream2(cctx,&out,&in,ZSTD_e_continue);
+		if ( ZSTD_isError(rc) )
+			return zstd_error(rc,Z_STREAM_ERROR);
+		outpos = out.pos;
+		filled = outpos == outsize;
+		if ( outsize - outpos <= out_threshold ) {
+			write_callback(arg);
+			if ( abortf )
+				return Aborted;
+		}
+	} while ( in.pos < in.size || filled );
+
+	in_total += in.pos;
+	return Z_OK;
+}
+
+int
+Zstd::decompress(void *buf,size_t bytes,void *arg) {
+	ZSTD_inBuffer in = { buf, bytes, 0 };
+	ZSTD_outBuffer out;
+	size_t rc;
+	bool filled;
+
+	if ( mode != Decompress || !dctx )
+		return Z_STREAM_ERROR;
+	if ( frame == 2 )
+		return Z_STREAM_END;		// Trailing input is ignored
+	frame = 1;
+
+	do	{
+		out = { outbuf, outsize, outpos };
+		rc = ZSTD_decompressStream(dctx,&out,&in);
+		in_total += in.pos;
+		in.src = (const char *)in.src + in.pos;
+		in.size -= in.pos;
+		in.pos = 0;
+		if ( ZSTD_isError(rc) )
+			return zstd_error(rc,Z_DATA_ERROR);
+		outpos = out.pos;
+		filled = outpos == outsize;
+		if ( rc == 0 ) {
+			frame = 2;		// End of frame
+			write_callback(arg);
+			return abortf ? Aborted : Z_STREAM_END;
+		}
+		if ( outsize - outpos <= out_threshold ) {
+			write_callback(arg);
+			if ( abortf )
+				return Aborted;
+		}
+	} while ( in.size > 0 || filled );
+
+	return Z_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Complete the stream: a compressor ends its frame (an empty frame
+// when no input was given), and a decompressor checks that its frame
+// ended. The stream is kept for reset().
+//////////////////////////////////////////////////////////////////////
+
+int
+Zstd::finish(void *arg) {
+	int rc;
+
+	if ( mode == Compress ) {
+		if ( !cctx || frame == 2 )
+			return Z_STREAM_ERROR;
+		rc = end_frame(arg);
+	} else	{
+		write_callback(arg);
+		rc = frame == 2 ? Z_OK : Z_DATA_ERROR;	// Empty or truncated
+	}
+	frame = 2;
+	return abortf ? Aborted : rc;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Make the stream ready for a new frame, keeping its context:
+//////////////////////////////////////////////////////////////////////
+
+void
+Zstd::reset() {
+
+	if ( cctx ) {
+		ZSTD_CCtx_reset(cctx,ZSTD_reset_session_only);
+		ZSTD_CCtx_setParameter(cctx,ZSTD_c_compressionLevel,level);
+	}
+	if ( dctx )
+		ZSTD_DCtx_reset(dctx,ZSTD_reset_session_only);
+	outpos = in_total = out_total = 0;
+	frame = 0;
+	abortf = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Set the compression level: applies now if no input was given yet,
+// else from the next reset().
+//////////////////////////////////////////////////////////////////////
+
+void
+Zstd::set_level(int level) {
+
+	this->level = level;
+	if ( cctx && frame == 0 )
+		ZSTD_CCtx_setParameter(cctx,ZSTD_c_compressionLevel,level);
+}
+
+#else	// !HAVE_ZSTD
+
+const bool Zstd::available = false;
+
+int Zstd::compress(void *,size_t,void *)	{ return Z_STREAM_ERROR; }
+int Zstd::decompress(void *,size_t,void *)	{ return Z_STREAM_ERROR; }
+int Zstd::finish(void *)			{ return Z_STREAM_ERROR; }
+void Zstd::set_level(int level)			{ this->level = level; }
+
+void
+Zstd::reset() {
+	outpos = in_total = out_total = 0;
+	frame = 0;
+	abortf = false;
+}
+
+#endif	// HAVE_ZSTD
+
+void
+Zstd::Release::operator()(Zstd *zstd) const noexcept {
+
+	if ( zstd->pool )
+		zstd->pool->put(zstd);
+	else	delete zstd;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Zstd stream pool
+//////////////////////////////////////////////////////////////////////
+
+ZstdPool::ZstdPool(size_t max_idle) : max_idle(max_idle) {
+	for ( auto& list : idle )
+		list.reserve(max_idle);		// put() does not allocate
+}
+
+ZstdPool::~ZstdPool() {
+	for ( auto& list : idle ) {
+		for ( Zstd *zstd : list )
+			delete zstd;
+		list.clear();
+	}
+}
+
+ZstdPool&
+ZstdPool::local() {
+	static thread_local ZstdPool pool;
+
+	return pool;
+}
+
+ZstdPtr
+ZstdPool::get(Zstd::Mode mode,Zstd::write_cb_t write_cb,int level) {
+	std::vector<Zstd*>& list = idle[mode];
+	Zstd *zstd;
+
+	if ( !list.empty() ) {
+		zstd = list.back();
+		list.pop_back();
+		zstd->level = level;
+		zstd->reset();
+		++reused;
+	} else	{
+		zstd = new Zstd(mode,outbuf_size,write_cb,level);
+		zstd->pool = this;
+		++created;
+	}
+	zstd->write_cb = write_cb;
+	return ZstdPtr(zstd);
+}
+
+void
+ZstdPool::put(Zstd *zstd) noexcept {
+	std::vector<Zstd*>& list = idle[zstd->mode];
+
+	if ( list.size() >= max_idle ) {
+		delete zstd;
+		return;
+	}
+	list.push_back(zstd);
+}
+
+// End zstd.cpp
@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////
+// zstd.hpp -- Zstandard compression
+// Date: Mon Oct 19 19:41:27 2026   (C) Warren W. Gay ve3wwg@gmail.com
+///////////////////////////////////////////////////////////////////////
+//
+// Zstd streams zstd frames with the same shape as Zlib: compress(),
+// decompress() and finish() pass output to a write callback, and
+// return the same codes (Z_OK, Z_STREAM_END, Z_DATA_ERROR ..).
+// Zstd::Aborted is returned after abort() from the write callback.
+//
+// libzstd is optional: build with make ZSTD=1 (HAVE_ZSTD). Without
+// it, available is false and the stream calls return Z_STREAM_ERROR.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef ZSTD_HPP
+#define ZSTD_HPP
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "gzip.hpp"
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+class ZstdPool;
+
+class Zstd {
+	friend ZstdPool;
+
+public:	typedef Zlib::write_cb_t write_cb_t;
+
+	enum Mode {
+		Compress,
+		Decompress
+	};
+
+private:
+	Mode		mode;
+	ZSTD_CCtx_s	*cctx = nullptr;	// Compression context
+	ZSTD_DCtx_s	*dctx = nullptr;	// Decompression context
+	unsigned char	*outbuf;		// Output buffer
+	size_t		outsize;		// Output buffer size
+	size_t		outpos = 0;		// Bytes pending in outbuf
+	size_t		in_total = 0;		// Bytes consumed
+	size_t		out_total = 0;		// Bytes produced
+	int		level;			// zstd compression level
+	int		frame = 0;		// 0 before input, 1 in a frame, 2 frame ended
+	bool		abortf = false;		// abort() was called
+	ZstdPool	*pool = nullptr;	// Pool this stream returns to
+
+	void write_callback(void *arg);
+	int end_frame(void *arg);
+
+public:	write_cb_t	write_cb;		// Write callback
+
+	static const bool available;		// Built with libzstd
+	static const int Aborted = Zlib::Aborted;
+
+	Zstd(Mode mode,size_t outbufsize,write_cb_t write_cb,int level=1);
+	~Zstd();
+
+	struct Release {
+		void operator()(Zstd *zstd) const noexcept;	// Back to pool, or delete
+	};
+
+	void reset();
+	void set_level(int level);
+
+	int compress(void *buf,size_t bytes,void *arg);
+	int decompress(void *buf,size_t bytes,void *arg);
+	int finish(void *arg);
+	void abort() noexcept		{ abortf = true; }	// From write_cb: stop early
+
+	size_t total_in() const noexcept	{ return in_total; }
+	size_t total_out() const noexcept	{ return out_total; }
+
+	static int level_for(int zlib_level) noexcept;
+};
+
+typedef std::unique_ptr<Zstd,Zstd::Release> ZstdPtr;
+
+//////////////////////////////////////////////////////////////////////
+// Pool of zstd streams, per thread as for ZlibPool. A zstd context is
+// large (its window and match tables), so reusing it matters more
+// than for zlib.
+//////////////////////////////////////////////////////////////////////
+
+class ZstdPool {
+	std::vector<Zstd*> idle[2];		// Streams ready for reuse, by Mode
+	size_t		max_idle;		// Per mode
+
+public:	size_t		created = 0;		// Streams constructed
+	size_t		reused = 0;		// Streams handed out again
+
+	static const size_t outbuf_size = 16*1024;
+
+	ZstdPool(size_t max_idle=16);
+	~ZstdPool();
+
+	ZstdPtr get(Zstd::Mode mode,Zstd::write_cb_t write_cb,int level=1);
+	void put(Zstd *zstd) noexcept;
+
+	static ZstdPool& local();
+};
+
+#endif // ZSTD_HPP
+
+// End zstd.hpp